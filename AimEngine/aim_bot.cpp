@@ -0,0 +1,155 @@
+#include "aim_bot.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+AimBot::AimBot(const SimConfig& config, const AimModel& model, uint64_t seed)
+    : config(config),
+      model(model),
+      rng(seed),
+      cursor(config.screenWidth / 2.0f, config.screenHeight / 2.0f) {
+    focalPixels = config.screenHeight / 2.0f / std::tan(glm::radians(config.fovDegrees) / 2.0f);
+    // Moving the mouse moves the cursor and turns the camera, which carries the target the
+    // other way on screen; near the middle of the screen both add up to this
+    closingPixels = 1.0f + Camera(config.cameraStart).MouseSensitivity * glm::radians(focalPixels);
+}
+
+void AimBot::Update(const SimSnapshot& snapshot, double time, std::vector<InputEvent>& events) {
+    Camera view(snapshot.cameraPosition);
+    view.Yaw = snapshot.yaw;
+    view.Pitch = snapshot.pitch;
+    glm::mat4 projection = glm::perspective(glm::radians(config.fovDegrees), config.screenWidth / config.screenHeight, config.nearPlane, config.farPlane);
+    glm::mat4 viewProjection = projection * view.GetViewMatrix();
+    float tick = 1.0f / config.tickRate;
+
+    // A hit respawns the target somewhere else, so the bot looks for the next one
+    if (target < 0 || snapshot.hits != hits) {
+        hits = snapshot.hits;
+        ChooseTarget(snapshot, viewProjection, time);
+    }
+
+    seen[seenCount % DELAY_TICKS] = snapshot.targets[target].position;
+    seenCount++;
+    int delay = std::min({ seenCount - 1, DELAY_TICKS - 1, static_cast<int>(model.visualDelayMs * 1e-3f * config.tickRate) });
+    glm::vec2 screen;
+    float depth;
+    if (!Project(viewProjection, seen[(seenCount - 1 - delay) % DELAY_TICKS], screen, depth)) {
+        ChooseTarget(snapshot, viewProjection, time);
+        return;
+    }
+    float radiusPixels = snapshot.targets[target].radius * focalPixels / depth;
+    glm::vec2 gap = screen - cursor;
+
+    if (phase == Phase::REACT && time - phaseStart >= phaseLength) StartFlick(gap, radiusPixels, time);
+
+    // The gap the hand steers toward this tick; the current gap means holding still
+    glm::vec2 wanted = gap;
+    float gain = 1.0f;
+    if (phase == Phase::FLICK) {
+        float s = std::min(1.0f, static_cast<float>((time - phaseStart) / phaseLength));
+        float progress = s * s * s * (10.0f + s * (-15.0f + 6.0f * s));
+        wanted = aimOffset + (flickGap - aimOffset) * (1.0f - progress);
+        if (s >= 1.0f) {
+            phase = Phase::SETTLE;
+            phaseStart = time;
+        }
+    }
+    else if (phase == Phase::SETTLE) {
+        wanted = aimOffset;
+        gain = 1.0f - std::exp(-tick / (model.trackingMs * 1e-3f));
+        bool onTarget = glm::length(gap) < radiusPixels;
+        double waited = time - std::max(phaseStart, lastClick);
+        if ((onTarget || corrections >= model.maxCorrections) && waited >= model.clickDelayMs * 1e-3) {
+            InputEvent click = {};
+            click.type = InputEvent::CLICK;
+            click.time = time;
+            events.push_back(click);
+            lastClick = time;
+            // A miss is corrected from scratch
+            if (!onTarget) corrections = 0;
+        }
+        else if (!onTarget && waited >= model.correctionMs * 1e-3) {
+            corrections++;
+            StartFlick(gap, radiusPixels, time);
+        }
+    }
+
+    glm::vec2 move = (gap - wanted) * gain / closingPixels;
+    if (model.tremorPixels > 0.0f) move += glm::vec2(rng.NextGaussian(), rng.NextGaussian()) * model.tremorPixels;
+    if (move == glm::vec2(0.0f)) return;
+    cursor += move;
+    InputEvent event = {};
+    event.type = InputEvent::MOUSE_MOVE;
+    event.time = time;
+    event.x = cursor.x;
+    event.y = cursor.y;
+    // The bot's window is the size of the simulation's screen
+    event.rawX = cursor.x;
+    event.rawY = cursor.y;
+    events.push_back(event);
+}
+
+// The target nearest the cursor on screen, after a reaction time
+void AimBot::ChooseTarget(const SimSnapshot& snapshot, const glm::mat4& viewProjection, double time) {
+    target = 0;
+    float nearest = FLT_MAX;
+    for (size_t i = 0; i < snapshot.targets.size(); ++i) {
+        glm::vec2 screen;
+        float depth;
+        if (!Project(viewProjection, snapshot.targets[i].position, screen, depth)) continue;
+        float distance = glm::length(screen - cursor);
+        if (distance < nearest) {
+            nearest = distance;
+            target = static_cast<int>(i);
+        }
+    }
+    seenCount = 0;
+    corrections = 0;
+    phase = Phase::REACT;
+    phaseStart = time;
+    phaseLength = std::max(0.05f, model.reactionMs + model.reactionJitterMs * rng.NextGaussian()) * 1e-3;
+}
+
+void AimBot::StartFlick(const glm::vec2& gap, float radiusPixels, double time) {
+    float distance = glm::length(gap);
+    phase = Phase::FLICK;
+    phaseStart = time;
+    phaseLength = (model.fittsAMs + model.fittsBMs * std::log2(distance / (2.0f * radiusPixels) + 1.0f)) * 1e-3;
+    flickGap = gap;
+    aimOffset = glm::vec2(rng.NextGaussian(), rng.NextGaussian()) * (model.endpointError * distance);
+}
+
+bool AimBot::Project(const glm::mat4& viewProjection, const glm::vec3& position, glm::vec2& screen, float& depth) const {
+    glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+    if (clip.w <= config.nearPlane) return false;
+    screen.x = (clip.x / clip.w * 0.5f + 0.5f) * config.screenWidth;
+    screen.y = (0.5f - clip.y / clip.w * 0.5f) * config.screenHeight;
+    depth = clip.w;
+    return true;
+}
+
+BotSessionResult RunBotSession(const SimConfig& config, const AimModel& model, uint64_t botSeed, double seconds) {
+    Simulation simulation(config);
+    AimBot bot(config, model, botSeed);
+    uint64_t ticks = static_cast<uint64_t>(seconds * config.tickRate);
+    double interval = 1.0 / config.tickRate;
+    std::vector<InputEvent> events;
+    events.reserve(4);
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        events.clear();
+        // Input lands mid-tick, as it does from the window thread
+        bot.Update(simulation.LatestSnapshot(), (tick + 0.5) * interval, events);
+        simulation.Step(events);
+    }
+
+    const SimSnapshot& snapshot = simulation.LatestSnapshot();
+    BotSessionResult result;
+    result.ticks = simulation.CurrentTick();
+    result.shots = snapshot.shots;
+    result.hits = snapshot.hits;
+    result.sweptHits = snapshot.sweptHits;
+    result.stateHash = simulation.StateHash();
+    result.shotStats = snapshot.shotStats;
+    return result;
+}
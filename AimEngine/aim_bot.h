@@ -0,0 +1,82 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "simulation.h"
+#include "random.h"
+
+// How a simulated player aims. Each target gets a reaction time, then a flick: a smooth
+// (minimum-jerk) movement whose length sets its duration by Fitts' law and whose landing
+// point scatters in proportion to that length. A flick that lands off the target is
+// followed by a shorter corrective one, so accuracy and time to kill depend on target
+// size, distance and speed the way they do for people.
+struct AimModel {
+    float reactionMs = 200.0f;      // Mean time from a new target to starting the flick
+    float reactionJitterMs = 30.0f; // Standard deviation of it
+    float visualDelayMs = 50.0f;    // Age of the target position the bot steers by
+    // Flick duration: a + b * log2(distance / width + 1)
+    float fittsAMs = 80.0f;
+    float fittsBMs = 100.0f;
+    float endpointError = 0.1f;     // Standard deviation of a flick's landing point, per unit of its length
+    float correctionMs = 120.0f;    // Time to see a flick land off target and start another
+    int maxCorrections = 3;         // Corrective flicks before the bot clicks wherever it is
+    float clickDelayMs = 40.0f;     // Time on target before clicking
+    float trackingMs = 60.0f;       // Time constant of following a moving target between flicks
+    float tremorPixels = 0.3f;      // Standard deviation of hand jitter per mouse sample
+};
+
+// Drives a Simulation's input like a player with the given aim model. Owns all of its
+// state, random stream included, so any number of bots can run on different threads.
+class AimBot {
+public:
+    AimBot(const SimConfig& config, const AimModel& model, uint64_t seed);
+
+    // Appends the input for the tick being simulated, stamped with time, given the state
+    // the previous tick published
+    void Update(const SimSnapshot& snapshot, double time, std::vector<InputEvent>& events);
+
+private:
+    enum class Phase { REACT, FLICK, SETTLE };
+
+    // Target positions kept for the visual delay, one per tick
+    static const int DELAY_TICKS = 256;
+
+    SimConfig config;
+    AimModel model;
+    Rng rng;
+    float focalPixels;   // Screen pixels per unit of view-space slope
+    float closingPixels; // Change in the cursor-to-target gap per pixel of mouse movement
+
+    glm::vec2 cursor;
+    int target = -1;
+    int hits = 0;
+    Phase phase = Phase::REACT;
+    double phaseStart = 0.0;
+    double phaseLength = 0.0;
+    glm::vec2 flickGap = glm::vec2(0.0f); // Gap when the flick started
+    glm::vec2 aimOffset = glm::vec2(0.0f); // Where the flick lands, relative to the target
+    int corrections = 0;
+    double lastClick = -1.0;
+
+    glm::vec3 seen[DELAY_TICKS];
+    int seenCount = 0;
+
+    void ChooseTarget(const SimSnapshot& snapshot, const glm::mat4& viewProjection, double time);
+    void StartFlick(const glm::vec2& gap, float radiusPixels, double time);
+    // Screen position of a world point; false behind the camera
+    bool Project(const glm::mat4& viewProjection, const glm::vec3& position, glm::vec2& screen, float& depth) const;
+};
+
+struct BotSessionResult {
+    uint64_t ticks = 0;
+    int shots = 0;
+    int hits = 0;
+    int sweptHits = 0;
+    uint64_t stateHash = 0;
+    ShotStats::Summary shotStats;
+};
+
+// Plays seconds of the scenario in config with one bot, on the calling thread. Everything
+// a session touches is its own, so sessions can run on many threads at once, and one
+// gives the same result whichever thread runs it.
+BotSessionResult RunBotSession(const SimConfig& config, const AimModel& model, uint64_t botSeed, double seconds);
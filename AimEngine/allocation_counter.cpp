@@ -0,0 +1,104 @@
+#include "allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef AIM_COUNT_ALLOCATIONS
+
+namespace {
+
+// Plain integers: thread_local without a constructor is safe to touch from operator new
+// at any point in a thread's life
+thread_local uint64_t threadAllocations = 0;
+thread_local uint64_t threadBytes = 0;
+std::atomic<uint64_t> totalAllocations{ 0 };
+
+void Count(size_t size) {
+    threadAllocations++;
+    threadBytes += size;
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* Allocate(size_t size) {
+    Count(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* AllocateAligned(size_t size, size_t alignment) {
+    Count(size);
+    if (size == 0) size = 1;
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void* p = nullptr;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+#endif
+}
+
+void FreeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+}
+
+void* operator new(size_t size) {
+    if (void* p = Allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* p = Allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* p = AllocateAligned(size, static_cast<size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    if (void* p = AllocateAligned(size, static_cast<size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return AllocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return AllocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+
+bool AllocationCounter::Enabled() { return true; }
+uint64_t AllocationCounter::ThreadAllocations() { return threadAllocations; }
+uint64_t AllocationCounter::ThreadBytes() { return threadBytes; }
+uint64_t AllocationCounter::TotalAllocations() { return totalAllocations.load(std::memory_order_relaxed); }
+
+#else
+
+bool AllocationCounter::Enabled() { return false; }
+uint64_t AllocationCounter::ThreadAllocations() { return 0; }
+uint64_t AllocationCounter::ThreadBytes() { return 0; }
+uint64_t AllocationCounter::TotalAllocations() { return 0; }
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+// Heap allocations made through operator new. When AIM_COUNT_ALLOCATIONS is defined (the
+// default), the global operator new is replaced by one that counts calls per thread, so
+// a frame or a tick can check that it allocated nothing. Otherwise every count is 0.
+class AllocationCounter {
+public:
+    static bool Enabled();
+
+    // Allocations and bytes requested by the calling thread since it started
+    static uint64_t ThreadAllocations();
+    static uint64_t ThreadBytes();
+
+    // Allocations by every thread since the program started
+    static uint64_t TotalAllocations();
+};
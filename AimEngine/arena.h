@@ -0,0 +1,15 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Static level geometry: axis-aligned boxes that are drawn as scaled unit cubes and that
+// block shots
+struct ArenaBox {
+    glm::vec3 center;
+    glm::vec3 size;
+    glm::vec3 color;
+};
+
+inline const ArenaBox ARENA_BOXES[] = {
+    { glm::vec3(0.0f, -1.5f, 0.0f), glm::vec3(10.0f, 0.1f, 10.0f), glm::vec3(0.3f, 0.3f, 1.0f) }, // Ground
+    { glm::vec3(0.0f, 0.75f, 5.0f), glm::vec3(10.0f, 5.0f, 0.2f), glm::vec3(0.8f, 0.2f, 0.2f) },  // Wall behind the start
+};
@@ -0,0 +1,270 @@
+// Renders N frames of the aim trainer scene into an offscreen framebuffer and reports
+// frame-time percentiles. Runs without a window or GPU (Mesa llvmpipe via EGL).
+//
+//   aim_frame_bench [--frames N] [--warmup N] [--targets N] [--width W] [--height H] [--per-target]
+//                   [--threads N]        (job system threads for batching; default all)
+//                   [--trace out.json]   (Chrome trace of the measured frames; needs AIM_PROFILE)
+//                   [--max-allocs N]     (fail if a measured frame makes more heap allocations)
+//                   [--program-cache F]  (load and save linked programs, to time warm starts)
+//                   [--frame-cap FPS]    (pace frames like the game's low-latency mode)
+//                   [--frame-budget MS]  (scale the render resolution to fit GPU time in MS)
+//                   [--render-scale S]   (fixed render scale, 0.25 to 1)
+//                   [--target-model F] [--arena-model F]  (OBJ or baked models, loaded in the background)
+//                   [--no-mesh-cache]    (parse OBJ models every run instead of baking them)
+#include "../headless_context.h"
+#include "../renderer.h"
+#include "../camera.h"
+#include "../target_manager.h"
+#include "../arena.h"
+#include "../profiler.h"
+#include "../job_system.h"
+#include "../allocation_counter.h"
+#include "../program_cache.h"
+#include "../frame_pacer.h"
+#include "../resolution_controller.h"
+#include "../mesh_loader.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct BenchConfig {
+    int frames = 500;
+    int warmup = 20;
+    int targets = 1000;
+    int width = 1280;
+    int height = 720;
+    bool instanced = true;
+    int threads = 0; // 0 for the hardware thread count
+    const char* tracePath = nullptr;
+    int maxAllocations = -1; // Per measured frame; -1 to only report them
+    const char* programCachePath = nullptr;
+    double frameCap = 0.0; // 0 renders frames back to back
+    double frameBudget = 0.0; // 0 renders at renderScale
+    float renderScale = 1.0f;
+    const char* targetModel = nullptr;
+    const char* arenaModel = nullptr;
+    bool meshCache = true;
+};
+
+bool ParseArgs(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--frames") == 0 && hasValue) config.frames = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--warmup") == 0 && hasValue) config.warmup = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--targets") == 0 && hasValue) config.targets = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--width") == 0 && hasValue) config.width = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--height") == 0 && hasValue) config.height = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--per-target") == 0) config.instanced = false;
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) config.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--trace") == 0 && hasValue) config.tracePath = argv[++i];
+        else if (std::strcmp(arg, "--max-allocs") == 0 && hasValue) config.maxAllocations = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--program-cache") == 0 && hasValue) config.programCachePath = argv[++i];
+        else if (std::strcmp(arg, "--frame-cap") == 0 && hasValue) config.frameCap = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--frame-budget") == 0 && hasValue) config.frameBudget = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--render-scale") == 0 && hasValue) config.renderScale = (float)std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--target-model") == 0 && hasValue) config.targetModel = argv[++i];
+        else if (std::strcmp(arg, "--arena-model") == 0 && hasValue) config.arenaModel = argv[++i];
+        else if (std::strcmp(arg, "--no-mesh-cache") == 0) config.meshCache = false;
+        else {
+            std::fprintf(stderr, "unknown argument: %s\n", arg);
+            return false;
+        }
+    }
+    return config.frames > 0 && config.frameCap >= 0.0 && config.frameBudget >= 0.0 && config.targets >= 0 && config.threads >= 0 && config.width > 0 && config.height > 0;
+}
+
+double Percentile(const std::vector<double>& sorted, double p) {
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!ParseArgs(argc, argv, config)) return 1;
+
+    // Startup as the game does it, minus the window: models start loading at once, then
+    // context, programs and meshes
+    auto launch = std::chrono::steady_clock::now();
+    MeshLoader meshLoader;
+    int targetModelRequest = config.targetModel ? meshLoader.Load(config.targetModel, config.meshCache) : -1;
+    int arenaModelRequest = config.arenaModel ? meshLoader.Load(config.arenaModel, config.meshCache) : -1;
+    int arenaMesh = -1;
+    HeadlessContext context;
+    if (!context.Init(config.width, config.height)) return 1;
+    double contextMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launch).count();
+
+    JobSystem jobs(config.threads > 0 ? config.threads - 1 : -1);
+    auto initStart = std::chrono::steady_clock::now();
+    ProgramCache programCache;
+    if (config.programCachePath) programCache.Open(config.programCachePath, HeadlessContext::ProcAddress);
+    Renderer renderer;
+    renderer.Init(&programCache);
+    renderer.SetViewport(config.width, config.height);
+    renderer.SetJobSystem(&jobs);
+    programCache.Save();
+    double initMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initStart).count();
+    double firstFrameMs = 0.0;
+
+    // Same wall as the game, widened so larger counts still fit with spacing
+    float halfWidth = std::max(5.0f, 0.6f * std::sqrt((float)config.targets));
+    TargetManager targetManager(config.targets, -halfWidth, halfWidth, 1.0f, 1.0f + 2.0f * halfWidth, -10.0f, 0.25f);
+    Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)config.width / (float)config.height, 0.1f, 100.0f);
+
+    std::vector<double> frameMs;
+    frameMs.reserve(config.frames);
+    // Frame start to frame start, which the pacer holds to the cap
+    std::vector<double> intervalMs;
+    intervalMs.reserve(config.frames);
+    FramePacer pacer;
+    pacer.SetCap(config.frameCap);
+    ResolutionController resolution(config.frameBudget, Renderer::MIN_RENDER_SCALE);
+    double scaleTotal = 0.0, gpuTotal = 0.0;
+    float scaleMin = 1.0f;
+    int gpuFrames = 0;
+    auto lastStart = std::chrono::steady_clock::now();
+    RenderStats stats;
+    long long visibleTotal = 0, culledTotal = 0;
+    uint64_t allocationsTotal = 0, allocationsMax = 0;
+
+    AIM_PROFILE_THREAD("Render");
+    for (int frame = 0; frame < config.warmup + config.frames; ++frame) {
+        if (config.tracePath && frame == config.warmup) Profiler::BeginCapture();
+        Profiler::Collect();
+        pacer.WaitForFrameStart();
+        AIM_PROFILE_SCOPE("Frame");
+        auto start = std::chrono::steady_clock::now();
+        if (frame > config.warmup) intervalMs.push_back(std::chrono::duration<double, std::milli>(start - lastStart).count());
+        lastStart = start;
+        // Models are taken up between frames as they finish, as in the game; the measured
+        // frames all draw them
+        if (frame == config.warmup) meshLoader.Wait();
+        LoadedMesh loaded;
+        while (meshLoader.TakeLoaded(loaded)) {
+            if (!loaded.mesh) continue;
+            auto uploadStart = std::chrono::steady_clock::now();
+            int mesh = renderer.AddMesh(*loaded.mesh);
+            double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+            if (loaded.request == targetModelRequest) renderer.SetTargetMesh(mesh);
+            if (loaded.request == arenaModelRequest) arenaMesh = mesh;
+            std::printf("model:      %s, %d vertices, %d triangles, %s in %.2f ms, uploaded in %.2f ms, drawn from frame %d\n",
+                        loaded.path.c_str(), loaded.mesh->VertexCount(), loaded.mesh->IndexCount() / 3,
+                        loaded.fromCache ? "read from cache" : "loaded", loaded.loadMs, uploadMs, frame);
+        }
+        uint64_t allocationsBefore = AllocationCounter::ThreadAllocations();
+
+        // Slow sweep so the view changes from frame to frame
+        camera.Yaw = -90.0f + 20.0f * std::sin(frame * 0.02f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        float scale = resolution.Update(renderer.GetGpuFrameMs(), renderer.GetGpuFrameScale());
+        renderer.SetRenderScale(config.frameBudget > 0.0 ? scale : config.renderScale);
+        renderer.BeginFrame();
+        renderer.SetCamera(view, projection);
+        if (config.instanced) {
+            SphereInstance* sphereInstances = renderer.FrameMemory().Allocate<SphereInstance>(targetManager.targets.size());
+            int instanceCount = 0;
+            for (auto& target : targetManager.targets) {
+                if (!target.hit)
+                    sphereInstances[instanceCount++] = { target.position, target.radius, glm::vec3(1.0f, 0.3f, 0.3f) };
+            }
+            renderer.DrawSpheresInstanced(sphereInstances, instanceCount);
+        }
+        else {
+            for (auto& target : targetManager.targets) {
+                if (!target.hit) {
+                    glm::mat4 model = glm::translate(glm::mat4(1.0f), target.position);
+                    model = glm::scale(model, glm::vec3(target.radius));
+                    renderer.DrawSphere(model);
+                }
+            }
+        }
+
+        for (const ArenaBox& box : ARENA_BOXES) {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), box.center);
+            renderer.DrawCube(glm::scale(model, box.size), box.color);
+        }
+        if (arenaMesh >= 0) renderer.DrawMesh(arenaMesh, glm::mat4(1.0f), glm::vec3(0.6f, 0.6f, 0.6f));
+
+        renderer.EndFrame();
+        pacer.FrameSubmitted();
+        // Without a swap chain nothing paces the GPU, so wait for it explicitly
+        {
+            AIM_PROFILE_SCOPE("Finish");
+            context.Finish();
+        }
+
+        if (frame == 0) firstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launch).count();
+        if (frame >= config.warmup) {
+            uint64_t allocations = AllocationCounter::ThreadAllocations() - allocationsBefore;
+            allocationsTotal += allocations;
+            allocationsMax = std::max(allocationsMax, allocations);
+            frameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            stats = renderer.GetStats();
+            visibleTotal += stats.visible;
+            culledTotal += stats.culled;
+            scaleTotal += renderer.GetRenderScale();
+            scaleMin = std::min(scaleMin, renderer.GetRenderScale());
+            if (renderer.GetGpuFrameMs() >= 0.0) {
+                gpuTotal += renderer.GetGpuFrameMs();
+                gpuFrames++;
+            }
+        }
+    }
+
+    if (config.tracePath) {
+        Profiler::EndCapture();
+        if (Profiler::WriteChromeTrace(config.tracePath)) {
+            std::printf("trace:      %llu events (%llu dropped) -> %s\n", (unsigned long long)Profiler::CapturedEvents(),
+                        (unsigned long long)Profiler::DroppedEvents(), config.tracePath);
+        }
+    }
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double ms : frameMs) total += ms;
+
+    std::printf("renderer:   %s\n", context.GetRendererName());
+    std::printf("startup:    first frame after %.1f ms (context %.1f ms, renderer init %.1f ms, %d/%d programs from cache)\n", firstFrameMs,
+                contextMs, initMs, programCache.Hits(), programCache.Hits() + programCache.Misses());
+    std::printf("scene:      %d targets, %dx%d, %s, %d draws/frame, %d program + %d VAO binds/frame, %d vertices/frame\n", config.targets,
+                config.width, config.height, config.instanced ? "instanced" : "per-target", stats.drawCalls, stats.programBinds, stats.vaoBinds, stats.vertices);
+    std::printf("culling:    %s, %d threads, %.1f visible + %.1f culled targets/frame\n", CullKernelName(), jobs.ThreadCount(),
+                (double)visibleTotal / config.frames, (double)culledTotal / config.frames);
+    std::printf("frames:     %d (+%d warmup)\n", config.frames, config.warmup);
+    std::printf("mean:       %.3f ms (%.1f fps)\n", total / frameMs.size(), 1000.0 * frameMs.size() / total);
+    std::printf("p50/p90/p99: %.3f / %.3f / %.3f ms\n", Percentile(sorted, 0.50), Percentile(sorted, 0.90), Percentile(sorted, 0.99));
+    std::printf("max:        %.3f ms\n", sorted.back());
+    if (gpuFrames > 0) {
+        std::printf("gpu:        %.3f ms/frame mean", gpuTotal / gpuFrames);
+        if (config.frameBudget > 0.0) {
+            std::printf(", %.1f ms budget, render scale %.2f mean, %.2f min", config.frameBudget, scaleTotal / config.frames, scaleMin);
+        }
+        std::printf("\n");
+    }
+    if (config.frameCap > 0.0 && !intervalMs.empty()) {
+        std::sort(intervalMs.begin(), intervalMs.end());
+        std::printf("pacing:     %.0f fps cap, interval p50/p99 %.3f / %.3f ms, work estimate %.3f ms, oversleep %.3f ms\n", config.frameCap,
+                    Percentile(intervalMs, 0.50), Percentile(intervalMs, 0.99), pacer.WorkEstimateMs(), pacer.OversleepMs());
+    }
+    if (AllocationCounter::Enabled()) {
+        std::printf("heap:       %.2f allocations/frame, %llu max\n", (double)allocationsTotal / config.frames, (unsigned long long)allocationsMax);
+    }
+
+    context.Shutdown();
+    if (config.maxAllocations >= 0 && allocationsMax > (uint64_t)config.maxAllocations) {
+        std::printf("FAIL: a frame made %llu heap allocations, more than %d\n", (unsigned long long)allocationsMax, config.maxAllocations);
+        return 1;
+    }
+    return 0;
+}
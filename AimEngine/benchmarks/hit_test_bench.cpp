@@ -0,0 +1,99 @@
+// Shot cost against target count: scalar scan over the Target array, the SIMD kernel over
+// the SoA store, and TargetManager::Raycast (SIMD scan for small fields, grid above that).
+#include "../target_manager.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const float TARGET_RADIUS = 0.25f;
+const float TARGET_SPACING = 0.75f;
+const float TARGET_Z = -10.0f;
+const int RAYS_PER_RUN = 20000;
+
+int LinearRaycast(const std::vector<Target>& targets, const glm::vec3& origin, const glm::vec3& direction) {
+    int nearest = -1;
+    float nearestT = FLT_MAX;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        float t;
+        if (!targets[i].hit && targets[i].IntersectRay(origin, direction, t) && t < nearestT) {
+            nearestT = t;
+            nearest = static_cast<int>(i);
+        }
+    }
+    return nearest;
+}
+
+// Dense jittered wall, built directly so setup does not dominate the run
+void FillWall(TargetManager& manager, int count, float halfWidth, std::mt19937& rng) {
+    std::uniform_real_distribution<float> jitter(-0.1f, 0.1f);
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+    manager.targets.clear();
+    for (int i = 0; i < count; ++i) {
+        manager.targets.emplace_back(glm::vec3(-halfWidth + (i % columns) * TARGET_SPACING + jitter(rng),
+                                               -halfWidth + (i / columns) * TARGET_SPACING + jitter(rng),
+                                               TARGET_Z), TARGET_RADIUS);
+    }
+    manager.RebuildSpatialIndex();
+}
+
+}
+
+int main() {
+    const int counts[] = { 100, 1000, 10000, 100000 };
+    std::mt19937 rng(1234);
+
+    std::printf("ray kernel: %s\n", RayKernelName());
+    std::printf("%10s %14s %14s %14s %10s\n", "targets", "aos ns/ray", "soa ns/ray", "manager ns/ray", "hit rate");
+    for (int count : counts) {
+        float halfWidth = 0.5f * std::ceil(std::sqrt(static_cast<float>(count))) * TARGET_SPACING;
+        TargetManager manager(0, -halfWidth, halfWidth, -halfWidth, halfWidth, TARGET_Z, TARGET_RADIUS);
+        FillWall(manager, count, halfWidth, rng);
+
+        // Rays from a fixed eye point towards random points on the wall
+        glm::vec3 eye(0.0f, 0.0f, 3.0f);
+        std::uniform_real_distribution<float> onWall(-halfWidth, halfWidth);
+        std::vector<glm::vec3> origins(RAYS_PER_RUN, eye);
+        std::vector<glm::vec3> directions(RAYS_PER_RUN);
+        for (auto& direction : directions) {
+            direction = glm::normalize(glm::vec3(onWall(rng), onWall(rng), TARGET_Z) - eye);
+        }
+
+        int linearRays = count >= 10000 ? RAYS_PER_RUN / 20 : RAYS_PER_RUN;
+        std::vector<int> expected(linearRays);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < linearRays; ++i) {
+            expected[i] = LinearRaycast(manager.targets, origins[i], directions[i]);
+        }
+        double linearNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / linearRays;
+
+        int soaRays = count >= 10000 ? RAYS_PER_RUN / 5 : RAYS_PER_RUN;
+        std::vector<int> soaResults(soaRays);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < soaRays; ++i) {
+            float t = FLT_MAX;
+            soaResults[i] = RaySphereNearest(manager.GetSoA(), origins[i], directions[i], t);
+        }
+        double soaNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / soaRays;
+
+        std::vector<int> results(RAYS_PER_RUN);
+        start = std::chrono::steady_clock::now();
+        manager.RaycastBatch(origins.data(), directions.data(), RAYS_PER_RUN, results.data());
+        double managerNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / RAYS_PER_RUN;
+
+        int hits = 0;
+        for (int i = 0; i < RAYS_PER_RUN; ++i) {
+            if ((i < linearRays && results[i] != expected[i]) || (i < soaRays && soaResults[i] != results[i])) {
+                std::printf("mismatch on ray %d: manager %d, soa %d, aos %d\n", i, results[i],
+                            i < soaRays ? soaResults[i] : -2, i < linearRays ? expected[i] : -2);
+                return 1;
+            }
+            if (results[i] >= 0) hits++;
+        }
+
+        std::printf("%10d %14.1f %14.1f %14.1f %9.1f%%\n", count, linearNs, soaNs, managerNs, 100.0 * hits / RAYS_PER_RUN);
+    }
+    return 0;
+}
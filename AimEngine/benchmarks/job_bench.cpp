@@ -0,0 +1,155 @@
+// Scaling of the per-frame passes the job system splits up, from one thread to all of them:
+// moving a field of spline targets, a batch of hit tests and building the sphere draw list.
+// Also checks every thread count produces exactly what one thread does.
+//
+//   job_bench [--targets N] [--rays N] [--max-threads N]
+#include "../target_manager.h"
+#include "../sphere_batcher.h"
+#include "../job_system.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const float TARGET_RADIUS = 0.25f;
+const float TARGET_Z = -10.0f;
+const float TICK = 0.001f;
+const int RUNS = 200;
+
+struct BenchConfig {
+    int targets = 100000;
+    int rays = 10000;
+    int maxThreads = 0; // 0 for the hardware thread count
+};
+
+bool ParseArgs(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--targets") == 0 && hasValue) config.targets = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--rays") == 0 && hasValue) config.rays = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--max-threads") == 0 && hasValue) config.maxThreads = std::atoi(argv[++i]);
+        else {
+            std::fprintf(stderr, "unknown argument: %s\n", arg);
+            return false;
+        }
+    }
+    return config.targets > 0 && config.rays > 0 && config.maxThreads >= 0;
+}
+
+TargetManager MakeField(int count, MotionPattern pattern) {
+    // One target per two Poisson cells, as in placement_bench
+    float cell = 2.0f * TARGET_RADIUS * TargetManager::TARGET_SPACING;
+    float halfWidth = 0.5f * std::sqrt(2.0f * count) * cell;
+    TargetManager manager(count, -halfWidth, halfWidth, -halfWidth, halfWidth, TARGET_Z, TARGET_RADIUS, 42);
+    if (pattern != MotionPattern::STATIC) manager.SetMotion(pattern, 3.0f, 1.5f);
+    return manager;
+}
+
+// Milliseconds per run
+template <typename Run>
+double TimeRuns(Run run) {
+    run(); // Warm up caches and scratch buffers
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RUNS; ++i) {
+        run();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / RUNS;
+}
+
+struct Result {
+    double advanceMs, raycastMs, batchMs;
+    bool identical;
+};
+
+// Outputs of the single-thread run that every other thread count must reproduce
+struct Reference {
+    std::vector<float> x, y;
+    std::vector<int> hits;
+    std::vector<SphereInstance> batched;
+};
+
+bool SameInstances(const std::vector<SphereInstance>& a, const std::vector<SphereInstance>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(SphereInstance)) == 0;
+}
+
+Result Measure(const BenchConfig& config, int threads, Reference& reference) {
+    JobSystem jobs(threads - 1);
+    Result result;
+
+    // Targets: the same field every time, so positions can be compared after RUNS + 1 ticks
+    TargetManager moving = MakeField(config.targets, MotionPattern::SPLINE);
+    result.advanceMs = TimeRuns([&] { moving.Advance(TICK, &jobs); });
+
+    // Hits: rays from the camera spread across a static field
+    TargetManager field = MakeField(config.targets, MotionPattern::STATIC);
+    std::vector<glm::vec3> origins(config.rays, glm::vec3(0.0f));
+    std::vector<glm::vec3> directions(config.rays);
+    Rng rng(7);
+    float halfWidth = 0.5f * std::sqrt(2.0f * config.targets) * 2.0f * TARGET_RADIUS * TargetManager::TARGET_SPACING;
+    for (glm::vec3& direction : directions) {
+        float x = (2.0f * rng.Next01() - 1.0f) * halfWidth;
+        float y = (2.0f * rng.Next01() - 1.0f) * halfWidth;
+        direction = glm::normalize(glm::vec3(x, y, TARGET_Z));
+    }
+    std::vector<int> hits(config.rays);
+    result.raycastMs = TimeRuns([&] { field.RaycastBatch(origins.data(), directions.data(), config.rays, hits.data(), &jobs); });
+
+    // Draw list: one instance per target, seen by the game's camera from further back
+    std::vector<SphereInstance> instances;
+    instances.reserve(config.targets);
+    for (const Target& target : field.targets) {
+        instances.push_back({ target.position, target.radius, glm::vec3(1.0f, 0.0f, 0.0f) });
+    }
+    SphereBatcher batcher;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.4f * halfWidth), glm::vec3(0.0f, 0.0f, TARGET_Z), glm::vec3(0.0f, 1.0f, 0.0f));
+    batcher.SetView(view, glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 1000.0f), 720);
+    std::vector<SphereInstance> batched;
+    FrameArena arena;
+    result.batchMs = TimeRuns([&] {
+        batched.clear();
+        arena.Reset();
+        batcher.Append(instances.data(), (int)instances.size(), batched, arena, &jobs);
+    });
+
+    const TargetSoA& soa = moving.GetSoA();
+    if (threads == 1) {
+        reference.x = soa.x;
+        reference.y = soa.y;
+        reference.hits = hits;
+        reference.batched = batched;
+    }
+    result.identical = soa.x == reference.x && soa.y == reference.y && hits == reference.hits && SameInstances(batched, reference.batched);
+    return result;
+}
+
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!ParseArgs(argc, argv, config)) return 1;
+    int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    int maxThreads = config.maxThreads > 0 ? config.maxThreads : hardwareThreads;
+
+    std::printf("hardware threads: %d, motion kernel: %s, cull kernel: %s\n", hardwareThreads, MotionKernelName(), CullKernelName());
+    std::printf("%d spline targets advanced, %d rays cast at %d static targets, %d instances batched; ms per pass\n",
+                config.targets, config.rays, config.targets, config.targets);
+    std::printf("%8s %12s %8s %12s %8s %12s %8s %10s\n", "threads", "advance", "speedup", "raycast", "speedup", "batch", "speedup", "results");
+
+    Reference reference;
+    Result single{};
+    for (int threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(threads * 2, maxThreads) : threads + 1) {
+        Result result = Measure(config, threads, reference);
+        if (threads == 1) single = result;
+        std::printf("%8d %12.3f %7.2fx %12.3f %7.2fx %12.3f %7.2fx %10s\n", threads, result.advanceMs, single.advanceMs / result.advanceMs,
+                    result.raycastMs, single.raycastMs / result.raycastMs, result.batchMs, single.batchMs / result.batchMs,
+                    result.identical ? "identical" : "DIVERGED");
+    }
+    return 0;
+}
@@ -0,0 +1,665 @@
+// Microbenchmarks for the engine's hot paths at several target counts: hit tests, target
+// placement and respawn, target motion, sphere mesh generation and batching, and camera /
+// projection math. Each case runs for at least --min-time seconds per repetition and
+// reports the median. --json writes the results in Google Benchmark's JSON layout, so runs
+// can be stored and compared with its tools or with --baseline. Before timing the collision
+// world, its queries are checked against a linear scan; a mismatch exits non-zero.
+//
+//   aim_microbench [--filter TEXT] [--min-time S] [--repetitions N] [--list]
+//                  [--json out.json] [--baseline old.json [--threshold PCT]]
+#include "../target_manager.h"
+#include "../collision_world.h"
+#include "../arena.h"
+#include "../camera.h"
+#include "../frustum.h"
+#include "../sphere_batcher.h"
+#include "../sphere_mesh.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const float TARGET_RADIUS = 0.25f;
+const float TARGET_Z = -10.0f;
+const int TARGET_COUNTS[] = { 100, 1000, 10000, 100000 };
+const int RAY_COUNT = 4096; // Rays cycled through by the hit-test cases
+const int SWEEP_VIEWS = 16;  // Mouse samples in one swept shot, about a frame at 1 kHz
+const float SWEEP_RADIANS = 0.1f; // How far the aim turns across them, a quick flick
+const int CHECK_RAYS = 256;       // Rays per pass of the collision world check
+
+struct BenchConfig {
+    const char* filter = nullptr;
+    double minTime = 0.1;
+    int repetitions = 3;
+    bool list = false;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    double threshold = 10.0; // Percent slower than the baseline that counts as a regression
+};
+
+bool ParseArgs(int argc, char** argv, BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--filter") == 0 && hasValue) config.filter = argv[++i];
+        else if (std::strcmp(arg, "--min-time") == 0 && hasValue) config.minTime = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--repetitions") == 0 && hasValue) config.repetitions = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--list") == 0) config.list = true;
+        else if (std::strcmp(arg, "--json") == 0 && hasValue) config.jsonPath = argv[++i];
+        else if (std::strcmp(arg, "--baseline") == 0 && hasValue) config.baselinePath = argv[++i];
+        else if (std::strcmp(arg, "--threshold") == 0 && hasValue) config.threshold = std::atof(argv[++i]);
+        else {
+            std::fprintf(stderr, "unknown argument: %s\n", arg);
+            return false;
+        }
+    }
+    return config.minTime > 0.0 && config.repetitions > 0 && config.threshold >= 0.0;
+}
+
+// Results feed this so the compiler cannot drop the work that produced them
+volatile float sink;
+inline void Consume(float value) { sink = sink + value; }
+
+// A benchmark case runs its operation `iterations` times; setup happens before it is timed
+struct Case {
+    std::string name;
+    int targets; // 0 when the case does not depend on a target count
+    std::function<std::function<void(int64_t)>()> setup;
+};
+
+struct Result {
+    std::string name;
+    int targets;
+    int64_t iterations;
+    double realNs; // Per operation, median over repetitions
+    double cpuNs;
+};
+
+float FieldHalfWidth(int count) {
+    // One target per two Poisson cells, as in placement_bench
+    return 0.5f * std::sqrt(2.0f * count) * 2.0f * TARGET_RADIUS * TargetManager::TARGET_SPACING;
+}
+
+TargetManager MakeField(int count, MotionPattern pattern = MotionPattern::STATIC) {
+    float halfWidth = FieldHalfWidth(count);
+    TargetManager manager(count, -halfWidth, halfWidth, -halfWidth, halfWidth, TARGET_Z, TARGET_RADIUS, 42);
+    if (pattern != MotionPattern::STATIC) manager.SetMotion(pattern, 3.0f, 1.5f);
+    return manager;
+}
+
+struct Box {
+    glm::vec3 min, max;
+};
+
+// The arena and a box for every 16 targets, scattered in front of them: level geometry at
+// the same scale as the field
+std::vector<Box> MakeBoxes(int count) {
+    std::vector<Box> boxes;
+    for (const ArenaBox& box : ARENA_BOXES) boxes.push_back({ box.center - 0.5f * box.size, box.center + 0.5f * box.size });
+    float halfWidth = FieldHalfWidth(count);
+    Rng rng(11);
+    for (int i = 0; i < count / 16; ++i) {
+        glm::vec3 center((2.0f * rng.Next01() - 1.0f) * halfWidth, (2.0f * rng.Next01() - 1.0f) * halfWidth, TARGET_Z + 1.0f + 4.0f * rng.Next01());
+        boxes.push_back({ center - glm::vec3(0.2f), center + glm::vec3(0.2f) });
+    }
+    return boxes;
+}
+
+// MakeBoxes and the field's targets; margin as the simulation's
+std::shared_ptr<CollisionWorld> MakeWorld(const TargetManager& field, int count, float margin = 0.0f) {
+    auto world = std::make_shared<CollisionWorld>();
+    for (const Box& box : MakeBoxes(count)) world->AddBox(box.min, box.max);
+    for (const Target& target : field.targets) world->AddSphere(target.position, target.radius, margin);
+    world->Build();
+    return world;
+}
+
+// Rays from the camera's start towards random points on the wall; about half hit
+void MakeRays(int count, std::vector<glm::vec3>& directions) {
+    float halfWidth = FieldHalfWidth(count);
+    Rng rng(7);
+    directions.resize(RAY_COUNT);
+    for (glm::vec3& direction : directions) {
+        float x = (2.0f * rng.Next01() - 1.0f) * halfWidth;
+        float y = (2.0f * rng.Next01() - 1.0f) * halfWidth;
+        direction = glm::normalize(glm::vec3(x, y, TARGET_Z - 3.0f));
+    }
+}
+
+// Flicks of SWEEP_RADIANS sideways ending on each of the rays, SWEEP_VIEWS directions each
+void MakeSweeps(int count, std::vector<glm::vec3>& directions) {
+    std::vector<glm::vec3> ends;
+    MakeRays(count, ends);
+    directions.resize(ends.size() * SWEEP_VIEWS);
+    for (size_t i = 0; i < ends.size(); ++i) {
+        glm::vec3 side = glm::normalize(glm::cross(ends[i], glm::vec3(0.0f, 1.0f, 0.0f)));
+        for (int k = 0; k < SWEEP_VIEWS; ++k) {
+            float back = SWEEP_RADIANS * (SWEEP_VIEWS - 1 - k) / (SWEEP_VIEWS - 1);
+            directions[i * SWEEP_VIEWS + k] = std::cos(back) * ends[i] - std::sin(back) * side;
+        }
+    }
+}
+
+// CollisionWorld's queries done the slow way, with its arithmetic and tie rules, so the
+// results must match exactly
+bool LinearSlab(const Box& box, const glm::vec3& origin, const glm::vec3& inverse, float tMax, float& tEnter) {
+    glm::vec3 t0 = (box.min - origin) * inverse;
+    glm::vec3 t1 = (box.max - origin) * inverse;
+    float tNear = std::max(std::max(std::min(t0.x, t1.x), std::min(t0.y, t1.y)), std::min(t0.z, t1.z));
+    float tFar = std::min(std::min(std::max(t0.x, t1.x), std::max(t0.y, t1.y)), std::max(t0.z, t1.z));
+    tEnter = std::max(tNear, 0.0f);
+    return tEnter <= std::min(tFar, tMax);
+}
+
+glm::vec3 InverseDirection(const glm::vec3& direction) {
+    glm::vec3 inverse;
+    for (int axis = 0; axis < 3; ++axis) {
+        float d = direction[axis];
+        inverse[axis] = 1.0f / (std::fabs(d) > 1e-12f ? d : std::copysign(1e-12f, d));
+    }
+    return inverse;
+}
+
+CollisionHit LinearRaycast(const std::vector<Box>& boxes, const std::vector<glm::vec3>& centers, const glm::vec3& origin, const glm::vec3& direction) {
+    glm::vec3 inverse = InverseDirection(direction);
+    CollisionHit hit;
+    float t;
+    for (int i = 0; i < static_cast<int>(boxes.size()); ++i) {
+        // Boxes first, so a sphere at the same t does not replace one
+        if (LinearSlab(boxes[i], origin, inverse, hit.t, t) && t < hit.t) hit = { CollisionHit::BOX, i, t };
+    }
+    for (int i = 0; i < static_cast<int>(centers.size()); ++i) {
+        glm::vec3 oc = origin - centers[i];
+        float b = oc.x * direction.x + oc.y * direction.y + oc.z * direction.z;
+        float c = oc.x * oc.x + oc.y * oc.y + oc.z * oc.z - TARGET_RADIUS * TARGET_RADIUS;
+        float discriminant = b * b - c;
+        if (discriminant < 0.0f) continue;
+        float root = std::sqrt(discriminant);
+        float tNear = -b - root;
+        t = tNear > 0.0f ? tNear : -b + root;
+        if (t > 0.0f && t < hit.t) hit = { CollisionHit::SPHERE, i, t };
+    }
+    return hit;
+}
+
+bool LinearOccluded(const std::vector<Box>& boxes, const glm::vec3& from, const glm::vec3& to) {
+    glm::vec3 offset = to - from;
+    float distance = glm::length(offset);
+    if (distance <= 0.0f) return false;
+    glm::vec3 inverse = InverseDirection(offset / distance);
+    float t;
+    for (const Box& box : boxes) {
+        if (LinearSlab(box, from, inverse, distance, t)) return true;
+    }
+    return false;
+}
+
+// Checks every CollisionWorld query against the linear scans: as built, after many moves
+// and respawns have been refitted into the tree, and after a rebuild. Prints the first
+// mismatch and returns false if there is one.
+bool CheckWorld(int count, MotionPattern pattern) {
+    const glm::vec3 eye(0.0f, 0.0f, 3.0f);
+    TargetManager field = MakeField(count, pattern);
+    std::vector<Box> boxes = MakeBoxes(count);
+    std::shared_ptr<CollisionWorld> world = MakeWorld(field, count, pattern != MotionPattern::STATIC ? 3.0f : 0.0f);
+    std::vector<glm::vec3> centers;
+    for (const Target& target : field.targets) centers.push_back(target.position);
+    std::vector<glm::vec3> directions;
+    MakeRays(count, directions);
+    float halfWidth = FieldHalfWidth(count);
+    Rng rng(13);
+
+    auto compare = [&](const char* stage) {
+        for (int i = 0; i < CHECK_RAYS; ++i) {
+            // Every other ray straight at a target, which may have just respawned
+            glm::vec3 direction = i % 2 ? glm::normalize(centers[(i * 7919) % count] - eye) : directions[i];
+            CollisionHit hit;
+            world->Raycast(eye, direction, hit);
+            CollisionHit expected = LinearRaycast(boxes, centers, eye, direction);
+            // Towards the near side of a target, as a swept hit checks
+            const glm::vec3& center = centers[i % count];
+            glm::vec3 front = center - TARGET_RADIUS * glm::normalize(center - eye);
+            bool occluded = world->Occluded(eye, front);
+            bool expectedOccluded = LinearOccluded(boxes, eye, front);
+            if (hit.kind != expected.kind || hit.id != expected.id || hit.t != expected.t || occluded != expectedOccluded) {
+                std::printf("collision world mismatch at %d targets %s, ray %d: raycast %d/%d/%g, linear %d/%d/%g; "
+                            "occluded %d, linear %d\n",
+                            count, stage, i, hit.kind, hit.id, hit.t, expected.kind, expected.id, expected.t, occluded, expectedOccluded);
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (!compare("as built")) return false;
+    for (int round = 0; round < 30; ++round) {
+        if (pattern != MotionPattern::STATIC) {
+            field.Advance(0.02f);
+            for (int k = 0; k < count; ++k) {
+                centers[k] = field.targets[k].position;
+                world->MoveSphere(k, centers[k]);
+            }
+        }
+        // Respawns jump out of their boxes, so the tree is reshaped as well as refitted. Few
+        // enough per query that the tree refits their paths rather than every node.
+        for (int r = 0; r < count / 500 + 1; ++r) {
+            int id = rng.NextInt(count);
+            centers[id] = glm::vec3((2.0f * rng.Next01() - 1.0f) * halfWidth, (2.0f * rng.Next01() - 1.0f) * halfWidth, TARGET_Z);
+            world->MoveSphere(id, centers[id]);
+        }
+        if (!compare("after moves")) return false;
+    }
+    world->Build();
+    return compare("after a rebuild");
+}
+
+void AddHitTestCases(std::vector<Case>& cases) {
+    const glm::vec3 eye(0.0f, 0.0f, 3.0f);
+    for (int count : TARGET_COUNTS) {
+        cases.push_back({ "hit_test/raycast/" + std::to_string(count), count, [=] {
+            auto field = std::make_shared<TargetManager>(MakeField(count));
+            auto directions = std::make_shared<std::vector<glm::vec3>>();
+            MakeRays(count, *directions);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    Consume(static_cast<float>(field->Raycast(eye, (*directions)[i & (RAY_COUNT - 1)])));
+                }
+            });
+        } });
+        cases.push_back({ "hit_test/raycast_moving/" + std::to_string(count), count, [=] {
+            auto field = std::make_shared<TargetManager>(MakeField(count, MotionPattern::SPLINE));
+            auto directions = std::make_shared<std::vector<glm::vec3>>();
+            MakeRays(count, *directions);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    Consume(static_cast<float>(field->Raycast(eye, (*directions)[i & (RAY_COUNT - 1)])));
+                }
+            });
+        } });
+        cases.push_back({ "hit_test/world_raycast/" + std::to_string(count), count, [=] {
+            auto world = MakeWorld(MakeField(count), count);
+            auto directions = std::make_shared<std::vector<glm::vec3>>();
+            MakeRays(count, *directions);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                CollisionHit hit;
+                for (int64_t i = 0; i < iterations; ++i) {
+                    world->Raycast(eye, (*directions)[i & (RAY_COUNT - 1)], hit);
+                    Consume(hit.t);
+                }
+            });
+        } });
+        // A shot on a tick after every target moved: syncing them in and the query. Targets
+        // alternate between two ticks' positions, so motion itself is not timed.
+        cases.push_back({ "hit_test/world_moving/" + std::to_string(count), count, [=] {
+            TargetManager field = MakeField(count, MotionPattern::SPLINE);
+            auto world = MakeWorld(field, count, 3.0f);
+            auto positions = std::make_shared<std::vector<glm::vec3>>();
+            for (const Target& target : field.targets) positions->push_back(target.position);
+            field.Advance(0.001f);
+            for (const Target& target : field.targets) positions->push_back(target.position);
+            auto directions = std::make_shared<std::vector<glm::vec3>>();
+            MakeRays(count, *directions);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                CollisionHit hit;
+                for (int64_t i = 0; i < iterations; ++i) {
+                    const glm::vec3* tick = positions->data() + (i & 1) * count;
+                    for (int k = 0; k < count; ++k) world->MoveSphere(k, tick[k]);
+                    world->Raycast(eye, (*directions)[i & (RAY_COUNT - 1)], hit);
+                    Consume(hit.t);
+                }
+            });
+        } });
+        // A shot after a respawn: the refit up the respawned target's path and the query
+        cases.push_back({ "hit_test/world_respawn/" + std::to_string(count), count, [=] {
+            auto world = MakeWorld(MakeField(count), count);
+            auto directions = std::make_shared<std::vector<glm::vec3>>();
+            MakeRays(count, *directions);
+            float halfWidth = FieldHalfWidth(count);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                Rng rng(3);
+                CollisionHit hit;
+                for (int64_t i = 0; i < iterations; ++i) {
+                    glm::vec3 spawn((2.0f * rng.Next01() - 1.0f) * halfWidth, (2.0f * rng.Next01() - 1.0f) * halfWidth, TARGET_Z);
+                    world->MoveSphere(rng.NextInt(count), spawn);
+                    world->Raycast(eye, (*directions)[i & (RAY_COUNT - 1)], hit);
+                    Consume(hit.t);
+                }
+            });
+        } });
+        cases.push_back({ "hit_test/nearest_miss/" + std::to_string(count), count, [=] {
+            auto field = std::make_shared<TargetManager>(MakeField(count));
+            auto directions = std::make_shared<std::vector<glm::vec3>>();
+            MakeRays(count, *directions);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                float distance;
+                for (int64_t i = 0; i < iterations; ++i) {
+                    Consume(static_cast<float>(field->NearestMiss(eye, (*directions)[i & (RAY_COUNT - 1)], distance)) + distance);
+                }
+            });
+        } });
+        cases.push_back({ "hit_test/sweep/" + std::to_string(count), count, [=] {
+            auto field = std::make_shared<TargetManager>(MakeField(count));
+            auto directions = std::make_shared<std::vector<glm::vec3>>();
+            MakeSweeps(count, *directions);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                float sweep = 0.0f;
+                for (int64_t i = 0; i < iterations; ++i) {
+                    const glm::vec3* path = directions->data() + (i & (RAY_COUNT - 1)) * SWEEP_VIEWS;
+                    Consume(static_cast<float>(field->SweepCast(eye, path, SWEEP_VIEWS, sweep)) + sweep);
+                }
+            });
+        } });
+    }
+}
+
+void AddPlacementCases(std::vector<Case>& cases) {
+    for (int count : TARGET_COUNTS) {
+        cases.push_back({ "placement/layout/" + std::to_string(count), count, [=] {
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    Consume(MakeField(count).targets.back().position.x);
+                }
+            });
+        } });
+        cases.push_back({ "placement/respawn/" + std::to_string(count), count, [=] {
+            auto field = std::make_shared<TargetManager>(MakeField(count));
+            auto rng = std::make_shared<Rng>(11);
+            float halfWidth = FieldHalfWidth(count);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    int id = rng->NextInt(count);
+                    field->MarkHit(id);
+                    field->ResetHitTargets(-halfWidth, halfWidth, -halfWidth, halfWidth, TARGET_Z);
+                    Consume(field->targets[id].position.x);
+                }
+            });
+        } });
+        cases.push_back({ "motion/spline_tick/" + std::to_string(count), count, [=] {
+            auto field = std::make_shared<TargetManager>(MakeField(count, MotionPattern::SPLINE));
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    field->Advance(0.001f);
+                }
+                Consume(field->targets[0].position.x);
+            });
+        } });
+    }
+}
+
+void AddSphereCases(std::vector<Case>& cases) {
+    for (int subdivisions = 0; subdivisions <= 4; ++subdivisions) {
+        cases.push_back({ "sphere_mesh/icosphere/" + std::to_string(subdivisions), 0, [=] {
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                std::vector<float> vertices;
+                std::vector<unsigned int> indices;
+                for (int64_t i = 0; i < iterations; ++i) {
+                    vertices.clear();
+                    indices.clear();
+                    GenerateIcosphere(subdivisions, vertices, indices);
+                    Consume(static_cast<float>(indices.size()));
+                }
+            });
+        } });
+    }
+    for (int count : TARGET_COUNTS) {
+        cases.push_back({ "sphere_batch/append/" + std::to_string(count), count, [=] {
+            TargetManager field = MakeField(count);
+            auto instances = std::make_shared<std::vector<SphereInstance>>();
+            for (const Target& target : field.targets) {
+                instances->push_back({ target.position, target.radius, glm::vec3(1.0f, 0.0f, 0.0f) });
+            }
+            auto batcher = std::make_shared<SphereBatcher>();
+            glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, TARGET_Z), glm::vec3(0.0f, 1.0f, 0.0f));
+            batcher->SetView(view, glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f), 1080);
+            auto batched = std::make_shared<std::vector<SphereInstance>>();
+            auto arena = std::make_shared<FrameArena>();
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    batched->clear();
+                    arena->Reset();
+                    Consume(static_cast<float>(batcher->Append(instances->data(), count, *batched, *arena).visible));
+                }
+            });
+        } });
+    }
+}
+
+void AddViewProjectionCases(std::vector<Case>& cases) {
+    const float aspect = 16.0f / 9.0f;
+    cases.push_back({ "view_projection/view_matrix", 0, [] {
+        return std::function<void(int64_t)>([](int64_t iterations) {
+            Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+            for (int64_t i = 0; i < iterations; ++i) {
+                camera.Yaw = -90.0f + 0.001f * static_cast<float>(i & 1023);
+                Consume(camera.GetViewMatrix()[3][2]);
+            }
+        });
+    } });
+    cases.push_back({ "view_projection/perspective", 0, [=] {
+        return std::function<void(int64_t)>([=](int64_t iterations) {
+            for (int64_t i = 0; i < iterations; ++i) {
+                float fov = glm::radians(45.0f + 0.001f * static_cast<float>(i & 1023));
+                Consume(glm::perspective(fov, aspect, 0.1f, 100.0f)[1][1]);
+            }
+        });
+    } });
+    cases.push_back({ "view_projection/ray_from_mouse", 0, [=] {
+        return std::function<void(int64_t)>([=](int64_t iterations) {
+            Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+            glm::mat4 view = camera.GetViewMatrix();
+            glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
+            for (int64_t i = 0; i < iterations; ++i) {
+                float x = static_cast<float>(i & 1023) * 1.875f;
+                Consume(GetRayFromMouse(x, 540.0f, 1920.0f, 1080.0f, projection, view).x);
+            }
+        });
+    } });
+    cases.push_back({ "view_projection/frustum_planes", 0, [=] {
+        return std::function<void(int64_t)>([=](int64_t iterations) {
+            Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+            glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
+            for (int64_t i = 0; i < iterations; ++i) {
+                camera.Yaw = -90.0f + 0.001f * static_cast<float>(i & 1023);
+                Consume(Frustum::FromViewProjection(projection * camera.GetViewMatrix()).planes[0].w);
+            }
+        });
+    } });
+    for (int count : TARGET_COUNTS) {
+        cases.push_back({ "view_projection/cull_spheres/" + std::to_string(count), count, [=] {
+            TargetManager field = MakeField(count);
+            auto instances = std::make_shared<std::vector<SphereInstance>>();
+            for (const Target& target : field.targets) {
+                instances->push_back({ target.position, target.radius, glm::vec3(1.0f) });
+            }
+            auto visible = std::make_shared<std::vector<int>>(count);
+            glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, TARGET_Z), glm::vec3(0.0f, 1.0f, 0.0f));
+            Frustum frustum = Frustum::FromViewProjection(glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f) * view);
+            return std::function<void(int64_t)>([=](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    Consume(static_cast<float>(CullSpheres(frustum, instances->data(), sizeof(SphereInstance), count, visible->data())));
+                }
+            });
+        } });
+    }
+}
+
+double CpuSeconds() {
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+// Grows the iteration count until one run takes minTime, then times the repetitions
+Result Run(const Case& benchCase, const BenchConfig& config) {
+    std::function<void(int64_t)> op = benchCase.setup();
+    int64_t iterations = 1;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        op(iterations);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds >= config.minTime) break;
+        double scale = seconds > 0.0 ? 1.2 * config.minTime / seconds : 10.0;
+        iterations = static_cast<int64_t>(iterations * std::min(10.0, std::max(2.0, scale)));
+    }
+
+    std::vector<double> realNs, cpuNs;
+    for (int r = 0; r < config.repetitions; ++r) {
+        double cpuStart = CpuSeconds();
+        auto start = std::chrono::steady_clock::now();
+        op(iterations);
+        realNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations);
+        cpuNs.push_back((CpuSeconds() - cpuStart) * 1e9 / iterations);
+    }
+    std::sort(realNs.begin(), realNs.end());
+    std::sort(cpuNs.begin(), cpuNs.end());
+    return { benchCase.name, benchCase.targets, iterations, realNs[realNs.size() / 2], cpuNs[cpuNs.size() / 2] };
+}
+
+std::string JsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool WriteJson(const char* path, const std::vector<Result>& results, const BenchConfig& config, const char* executable) {
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) {
+        std::fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+#ifdef NDEBUG
+    const char* buildType = "release";
+#else
+    const char* buildType = "debug";
+#endif
+
+    std::fprintf(file, "{\n  \"context\": {\n");
+    std::fprintf(file, "    \"date\": \"%s\",\n", date);
+    std::fprintf(file, "    \"executable\": \"%s\",\n", JsonEscape(executable).c_str());
+    std::fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(file, "    \"library_build_type\": \"%s\",\n", buildType);
+    std::fprintf(file, "    \"ray_kernel\": \"%s\",\n", RayKernelName());
+    std::fprintf(file, "    \"cull_kernel\": \"%s\",\n", CullKernelName());
+    std::fprintf(file, "    \"motion_kernel\": \"%s\"\n", MotionKernelName());
+    std::fprintf(file, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::fprintf(file, "    {\n");
+        std::fprintf(file, "      \"name\": \"%s\",\n", JsonEscape(result.name).c_str());
+        std::fprintf(file, "      \"run_name\": \"%s\",\n", JsonEscape(result.name).c_str());
+        std::fprintf(file, "      \"run_type\": \"iteration\",\n");
+        std::fprintf(file, "      \"repetitions\": %d,\n", config.repetitions);
+        std::fprintf(file, "      \"iterations\": %lld,\n", static_cast<long long>(result.iterations));
+        std::fprintf(file, "      \"real_time\": %.4f,\n", result.realNs);
+        std::fprintf(file, "      \"cpu_time\": %.4f,\n", result.cpuNs);
+        std::fprintf(file, "      \"time_unit\": \"ns\",\n");
+        std::fprintf(file, "      \"targets\": %d\n", result.targets);
+        std::fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+}
+
+// Reads the name and real_time of every entry of a file written by WriteJson (or by
+// Google Benchmark); not a general JSON parser
+bool ReadBaseline(const char* path, std::vector<std::pair<std::string, double>>& entries) {
+    std::ifstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    const std::string nameKey = "\"name\": \"", timeKey = "\"real_time\": ";
+    size_t cursor = 0;
+    while ((cursor = text.find(nameKey, cursor)) != std::string::npos) {
+        size_t nameStart = cursor + nameKey.size();
+        size_t nameEnd = text.find('"', nameStart);
+        size_t time = text.find(timeKey, nameEnd);
+        size_t next = text.find(nameKey, nameEnd);
+        if (nameEnd == std::string::npos || time == std::string::npos || (next != std::string::npos && time > next)) break;
+        entries.emplace_back(text.substr(nameStart, nameEnd - nameStart), std::atof(text.c_str() + time + timeKey.size()));
+        cursor = nameEnd;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!ParseArgs(argc, argv, config)) return 1;
+
+    std::vector<Case> cases;
+    AddHitTestCases(cases);
+    AddPlacementCases(cases);
+    AddSphereCases(cases);
+    AddViewProjectionCases(cases);
+    if (config.filter) {
+        cases.erase(std::remove_if(cases.begin(), cases.end(), [&](const Case& c) { return c.name.find(config.filter) == std::string::npos; }),
+                    cases.end());
+    }
+    if (config.list) {
+        for (const Case& benchCase : cases) std::printf("%s\n", benchCase.name.c_str());
+        return 0;
+    }
+
+    std::printf("kernels: ray %s, cull %s, motion %s\n", RayKernelName(), CullKernelName(), MotionKernelName());
+    if (std::any_of(cases.begin(), cases.end(), [](const Case& c) { return c.name.find("hit_test/world_") != std::string::npos; })) {
+        for (int count : { 1000, 5000 }) {
+            if (!CheckWorld(count, MotionPattern::STATIC) || !CheckWorld(count, MotionPattern::SPLINE)) return 1;
+        }
+        std::printf("collision world: matches a linear scan\n");
+    }
+    std::printf("%-40s %14s %14s %12s\n", "benchmark", "real ns/op", "cpu ns/op", "iterations");
+    std::vector<Result> results;
+    for (const Case& benchCase : cases) {
+        results.push_back(Run(benchCase, config));
+        const Result& result = results.back();
+        std::printf("%-40s %14.1f %14.1f %12lld\n", result.name.c_str(), result.realNs, result.cpuNs, static_cast<long long>(result.iterations));
+        std::fflush(stdout);
+    }
+
+    if (config.jsonPath && !WriteJson(config.jsonPath, results, config, argv[0])) return 1;
+
+    if (config.baselinePath) {
+        std::vector<std::pair<std::string, double>> baseline;
+        if (!ReadBaseline(config.baselinePath, baseline)) return 1;
+        int regressions = 0;
+        std::printf("\nagainst %s (regression above +%.0f%%):\n", config.baselinePath, config.threshold);
+        for (const Result& result : results) {
+            auto match = std::find_if(baseline.begin(), baseline.end(), [&](const std::pair<std::string, double>& entry) { return entry.first == result.name; });
+            if (match == baseline.end() || match->second <= 0.0) continue;
+            double change = 100.0 * (result.realNs / match->second - 1.0);
+            bool regressed = change > config.threshold;
+            regressions += regressed ? 1 : 0;
+            std::printf("%-40s %14.1f -> %14.1f %+8.1f%%%s\n", result.name.c_str(), match->second, result.realNs, change, regressed ? "  REGRESSION" : "");
+        }
+        if (regressions > 0) {
+            std::printf("%d regression(s)\n", regressions);
+            return 1;
+        }
+    }
+    return 0;
+}
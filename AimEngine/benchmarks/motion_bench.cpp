@@ -0,0 +1,69 @@
+// Cost of moving every target one simulation tick, per pattern and target count: the
+// TargetMotion kernel alone (scalar and SIMD) and the whole TargetManager::Advance, which
+// also syncs the Target array. Also checks that the scalar and SIMD kernels
+// move targets identically, which replays rely on.
+#include "../target_manager.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const float TARGET_RADIUS = 0.25f;
+const float TARGET_Z = -10.0f;
+const float TICK = 0.001f;
+const int TICKS_PER_RUN = 2000;
+
+TargetManager MakeField(int count, MotionPattern pattern) {
+    // One target per two Poisson cells, as in placement_bench
+    float cell = 2.0f * TARGET_RADIUS * TargetManager::TARGET_SPACING;
+    float halfWidth = 0.5f * std::sqrt(2.0f * count) * cell;
+    TargetManager manager(count, -halfWidth, halfWidth, -halfWidth, halfWidth, TARGET_Z, TARGET_RADIUS, 42);
+    manager.SetMotion(pattern, 3.0f, 1.5f);
+    return manager;
+}
+
+// Nanoseconds per target per tick
+template <typename Step>
+double TimeTicks(int count, Step step) {
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < TICKS_PER_RUN; ++tick) {
+        step();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / TICKS_PER_RUN / count;
+}
+
+}
+
+int main() {
+    const int counts[] = { 1000, 10000, 100000 };
+    const MotionPattern patterns[] = { MotionPattern::STRAFE, MotionPattern::CIRCLE, MotionPattern::SPLINE };
+
+    std::printf("motion kernel: %s\n", MotionKernelName());
+    std::printf("%8s %10s %16s %16s %18s %10s\n", "pattern", "targets", "scalar ns/target", "simd ns/target", "manager ns/target", "paths");
+    for (MotionPattern pattern : patterns) {
+        for (int count : counts) {
+            // The kernel alone, on copies of the same field so both paths start identical
+            TargetManager scalarField = MakeField(count, pattern);
+            TargetManager simdField = scalarField;
+            TargetMotion scalarMotion = scalarField.GetMotion();
+            TargetMotion simdMotion = scalarMotion;
+            TargetSoA scalarSoA = scalarField.GetSoA();
+            TargetSoA simdSoA = scalarSoA;
+
+            SetMotionKernelScalarOnly(true);
+            double scalarNs = TimeTicks(count, [&] { scalarMotion.Advance(TICK, scalarSoA); });
+            SetMotionKernelScalarOnly(false);
+            double simdNs = TimeTicks(count, [&] { simdMotion.Advance(TICK, simdSoA); });
+
+            bool identical = std::memcmp(scalarSoA.x.data(), simdSoA.x.data(), scalarSoA.x.size() * sizeof(float)) == 0 &&
+                             std::memcmp(scalarSoA.y.data(), simdSoA.y.data(), scalarSoA.y.size() * sizeof(float)) == 0;
+
+            double managerNs = TimeTicks(count, [&] { simdField.Advance(TICK); });
+
+            std::printf("%8s %10d %16.2f %16.2f %18.2f %10s\n", MotionPatternName(pattern), count, scalarNs, simdNs, managerNs,
+                        identical ? "identical" : "DIVERGED");
+        }
+    }
+    return 0;
+}
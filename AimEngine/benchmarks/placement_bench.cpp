@@ -0,0 +1,49 @@
+// Scenario load and respawn cost against target count with the Poisson-disk placer.
+// The spawn rectangle grows with the count so the field stays about half full.
+#include "../target_manager.h"
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+const float TARGET_RADIUS = 0.25f;
+const float TARGET_Z = -10.0f;
+const int RESPAWNS_PER_RUN = 20000;
+
+// Verifies the minimum spacing with a brute-force check on small fields
+bool SpacingHolds(const TargetManager& manager) {
+    float minDistance = 2.0f * TARGET_RADIUS * TargetManager::TARGET_SPACING;
+    for (size_t i = 0; i < manager.targets.size(); ++i)
+        for (size_t j = i + 1; j < manager.targets.size(); ++j)
+            if (glm::distance(manager.targets[i].position, manager.targets[j].position) < minDistance * 0.999f)
+                return false;
+    return true;
+}
+
+}
+
+int main() {
+    const int counts[] = { 10, 1000, 10000, 100000 };
+
+    std::printf("%10s %14s %18s %10s\n", "targets", "layout ms", "respawn ns/target", "spacing");
+    for (int count : counts) {
+        // One target per two Poisson cells
+        float cell = 2.0f * TARGET_RADIUS * TargetManager::TARGET_SPACING;
+        float halfWidth = 0.5f * std::sqrt(2.0f * count) * cell;
+
+        auto start = std::chrono::steady_clock::now();
+        TargetManager manager(count, -halfWidth, halfWidth, -halfWidth, halfWidth, TARGET_Z, TARGET_RADIUS);
+        double layoutMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < RESPAWNS_PER_RUN; ++i) {
+            manager.MarkHit((i * 7919) % count);
+            manager.ResetHitTargets(-halfWidth, halfWidth, -halfWidth, halfWidth, TARGET_Z);
+        }
+        double respawnNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / RESPAWNS_PER_RUN;
+
+        const char* spacing = count <= 10000 ? (SpacingHolds(manager) ? "ok" : "VIOLATED") : "-";
+        std::printf("%10d %14.2f %18.1f %10s\n", count, layoutMs, respawnNs, spacing);
+    }
+    return 0;
+}
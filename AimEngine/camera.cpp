@@ -40,3 +40,21 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset) {
     if (Pitch > 89.0f) Pitch = 89.0f;
     if (Pitch < -89.0f) Pitch = -89.0f;
 }
+
+// Function to create a ray from mouse position
+glm::vec3 GetRayFromMouse(float mouseX, float mouseY, float screenWidth, float screenHeight, const glm::mat4& projection, const glm::mat4& view) {
+    // Convert mouse coordinates to normalized device coordinates
+    float x = (2.0f * mouseX) / screenWidth - 1.0f;
+    float y = 1.0f - (2.0f * mouseY) / screenHeight;
+
+    // Create ray in clip space
+    glm::vec4 rayClip = glm::vec4(x, y, -1.0f, 1.0f);
+
+    // Convert to eye space
+    glm::vec4 rayEye = glm::inverse(projection) * rayClip;
+    rayEye = glm::vec4(rayEye.x, rayEye.y, -1.0f, 0.0f);
+
+    // Convert to world space
+    glm::vec3 rayWorld = glm::vec3(glm::inverse(view) * rayEye);
+    return glm::normalize(rayWorld);
+}
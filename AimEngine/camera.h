@@ -17,3 +17,6 @@ public:
     void ProcessKeyboard(bool* keys, float deltaTime);
     void ProcessMouseMovement(float xoffset, float yoffset);
 };
+
+// World-space direction of the ray through a cursor position given in window pixels
+glm::vec3 GetRayFromMouse(float mouseX, float mouseY, float screenWidth, float screenHeight, const glm::mat4& projection, const glm::mat4& view);
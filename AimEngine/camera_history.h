@@ -0,0 +1,85 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+
+// Recent camera state by timestamp, so a shot can be resolved against the view at the
+// moment of the click instead of whatever the camera looks like when the click is
+// processed. Orientation changes only on mouse events and is a step function; position
+// is integrated once per tick and is interpolated between ticks.
+class CameraHistory {
+public:
+    struct View {
+        double time;
+        float yaw, pitch;
+        float cursorX, cursorY;
+    };
+
+    struct PositionSample {
+        double time;
+        glm::vec3 position;
+    };
+
+    // Mouse events per second from the fastest polling mice
+    static const int MAX_MOUSE_RATE = 8000;
+    // A second of mouse events at that rate, a second of ticks at 1 kHz
+    static const size_t VIEW_CAPACITY = 8192;
+    static const size_t POSITION_CAPACITY = 1024;
+
+    // Times must not decrease between calls to the same Record function
+    void RecordView(double time, float yaw, float pitch, float cursorX, float cursorY) {
+        views[viewCount++ % VIEW_CAPACITY] = { time, yaw, pitch, cursorX, cursorY };
+    }
+
+    void RecordPosition(double time, const glm::vec3& position) {
+        positions[positionCount++ % POSITION_CAPACITY] = { time, position };
+    }
+
+    // Last view recorded at or before time (the oldest one kept if time is older still)
+    View ViewAt(double time) const {
+        size_t i = Latest(views, viewCount, VIEW_CAPACITY, time);
+        return views[i % VIEW_CAPACITY];
+    }
+
+    // The view in effect at start and every later one up to end, oldest first; at most
+    // capacity of them, keeping the newest. Returns how many were written.
+    int ViewsBetween(double start, double end, View* out, int capacity) const {
+        if (capacity <= 0) return 0;
+        size_t last = Latest(views, viewCount, VIEW_CAPACITY, end);
+        size_t first = Latest(views, viewCount, VIEW_CAPACITY, start);
+        first = std::max(first, last + 1 - std::min<size_t>(capacity, last + 1));
+        for (size_t i = first; i <= last; ++i) {
+            out[i - first] = views[i % VIEW_CAPACITY];
+        }
+        return static_cast<int>(last + 1 - first);
+    }
+
+    glm::vec3 PositionAt(double time) const {
+        size_t i = Latest(positions, positionCount, POSITION_CAPACITY, time);
+        const PositionSample& a = positions[i % POSITION_CAPACITY];
+        if (i + 1 >= positionCount || time <= a.time) return a.position;
+        const PositionSample& b = positions[(i + 1) % POSITION_CAPACITY];
+        float alpha = static_cast<float>((time - a.time) / (b.time - a.time));
+        return glm::mix(a.position, b.position, alpha);
+    }
+
+private:
+    View views[VIEW_CAPACITY];
+    PositionSample positions[POSITION_CAPACITY];
+    size_t viewCount = 0;
+    size_t positionCount = 0;
+
+    // Binary search over the retained window for the newest sample with sample.time <= time.
+    // Returns an absolute sample number; callers make sure something has been recorded.
+    template <typename Sample>
+    static size_t Latest(const Sample* samples, size_t count, size_t capacity, double time) {
+        size_t first = count > capacity ? count - capacity : 0;
+        size_t lo = first, hi = count; // answer in [lo, hi)
+        while (hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (samples[mid % capacity].time <= time) lo = mid;
+            else hi = mid;
+        }
+        return lo;
+    }
+};
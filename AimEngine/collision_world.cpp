@@ -0,0 +1,376 @@
+#include "collision_world.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Zero for the inside-out bounds of an empty leaf
+float Area(const glm::vec3& min, const glm::vec3& max) {
+    glm::vec3 d = glm::max(max - min, glm::vec3(0.0f));
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// Where the ray enters the box, clamped to the origin; false if it misses or enters past tMax
+bool Slab(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverse, float tMax, float& tEnter) {
+    glm::vec3 t0 = (min - origin) * inverse;
+    glm::vec3 t1 = (max - origin) * inverse;
+    float tNear = std::max(std::max(std::min(t0.x, t1.x), std::min(t0.y, t1.y)), std::min(t0.z, t1.z));
+    float tFar = std::min(std::min(std::max(t0.x, t1.x), std::max(t0.y, t1.y)), std::max(t0.z, t1.z));
+    tEnter = std::max(tNear, 0.0f);
+    return tEnter <= std::min(tFar, tMax);
+}
+
+// Boxes win ties against spheres, then the lower id does, so results do not depend on the
+// order the tree is walked in
+bool Closer(CollisionHit::Kind kind, int id, float t, const CollisionHit& hit) {
+    if (t != hit.t) return t < hit.t;
+    if (kind != hit.kind) return kind == CollisionHit::BOX;
+    return id < hit.id;
+}
+
+}
+
+int CollisionWorld::AddBox(const glm::vec3& min, const glm::vec3& max) {
+    boxes.push_back(static_cast<int>(items.size()));
+    items.push_back({ min, max, ~static_cast<int>(boxes.size() - 1) });
+    built = false;
+    return static_cast<int>(boxes.size()) - 1;
+}
+
+int CollisionWorld::AddSphere(const glm::vec3& center, float radius, float margin) {
+    int id = static_cast<int>(spheres.size());
+    spheres.push_back({ center, radius, center, margin, static_cast<int>(items.size()) });
+    glm::vec3 extent(radius + margin);
+    items.push_back({ center - extent, center + extent, id });
+    built = false;
+    return id;
+}
+
+void CollisionWorld::MoveSphere(int id, const glm::vec3& center) {
+    Sphere& sphere = spheres[id];
+    sphere.center = center;
+    glm::vec3 offset = glm::abs(center - sphere.anchor);
+    if (offset.x <= sphere.margin && offset.y <= sphere.margin && offset.z <= sphere.margin) return;
+
+    sphere.anchor = center;
+    glm::vec3 extent(sphere.radius + sphere.margin);
+    Item item = items[sphere.item];
+    item.min = center - extent;
+    item.max = center + extent;
+    if (!built) {
+        items[sphere.item] = item;
+        return;
+    }
+
+    // Out of its leaf: the last item there fills the gap
+    int from = slotLeaves[sphere.item];
+    int last = nodes[from].first + nodes[from].count - 1;
+    items[sphere.item] = items[last];
+    Claim(sphere.item);
+    nodes[from].count--;
+    Moved(from);
+
+    // Into the leaf its box enlarges least, or back where it was when that one is full
+    int to = 0;
+    while (nodes[to].count < 0) {
+        int left = to + 1, right = nodes[to].first;
+        float leftArea = Area(nodes[left].min, nodes[left].max);
+        float rightArea = Area(nodes[right].min, nodes[right].max);
+        float leftGrowth = Area(glm::min(nodes[left].min, item.min), glm::max(nodes[left].max, item.max)) - leftArea;
+        float rightGrowth = Area(glm::min(nodes[right].min, item.min), glm::max(nodes[right].max, item.max)) - rightArea;
+        to = leftGrowth < rightGrowth || (leftGrowth == rightGrowth && leftArea <= rightArea) ? left : right;
+    }
+    int slot = nodes[to].first + nodes[to].count;
+    if (slot == slotCount || slotLeaves[slot] != to) {
+        to = from;
+        slot = last;
+    }
+    items[slot] = item;
+    Claim(slot);
+    nodes[to].count++;
+    Moved(to);
+}
+
+void CollisionWorld::Claim(int slot) {
+    int ref = items[slot].ref;
+    if (ref < 0) boxes[~ref] = slot;
+    else spheres[ref].item = slot;
+}
+
+void CollisionWorld::Moved(int leaf) {
+    if (refitAll) return;
+    // Past about one leaf in four, one pass over every node is cheaper than the paths
+    if (movedLeaves.size() * LEAF_SIZE >= nodes.size()) refitAll = true;
+    else movedLeaves.push_back(leaf);
+}
+
+void CollisionWorld::Build() {
+    // Gather the items out of the leaf slots, then those added since
+    sorted.clear();
+    for (const Node& node : nodes) {
+        if (node.count > 0) sorted.insert(sorted.end(), items.begin() + node.first, items.begin() + node.first + node.count);
+    }
+    sorted.insert(sorted.end(), items.begin() + slotCount, items.end());
+    items.swap(sorted);
+
+    order.resize(items.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+    // Capacity survives a rebuild, so rebuilding a world of the same size never allocates
+    nodes.clear();
+    parents.clear();
+    if (!items.empty()) BuildNode(0, static_cast<int>(items.size()), -1, 0);
+
+    // Lay the leaves out side by side, each with room to take in spheres that move to it
+    int slots = 0;
+    for (const Node& node : nodes) {
+        if (node.count >= 0) slots += std::max(node.count, static_cast<int>(LEAF_SLOTS));
+    }
+    sorted.resize(slots);
+    slotLeaves.resize(slots);
+    int slot = 0;
+    for (int i = 0; i < static_cast<int>(nodes.size()); ++i) {
+        Node& node = nodes[i];
+        if (node.count < 0) continue;
+        int begin = node.first;
+        node.first = slot;
+        for (int k = 0; k < node.count; ++k) sorted[slot + k] = items[order[begin + k]];
+        int end = slot + std::max(node.count, static_cast<int>(LEAF_SLOTS));
+        std::fill(slotLeaves.begin() + slot, slotLeaves.begin() + end, i);
+        slot = end;
+    }
+    items.swap(sorted);
+    slotCount = slots;
+    for (const Node& node : nodes) {
+        if (node.count > 0) {
+            for (int k = node.first; k < node.first + node.count; ++k) Claim(k);
+        }
+    }
+
+    // Children come after their parent, so one backward pass fits every child first
+    cost = 0.0f;
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i) {
+        FitNode(i);
+        cost += Area(nodes[i].min, nodes[i].max);
+    }
+    builtCost = cost;
+    movedLeaves.clear();
+    movedLeaves.reserve(nodes.size() / LEAF_SIZE + 1);
+    refitAll = false;
+    built = true;
+}
+
+// Node over order[begin, end), which it partitions. Splits at the best of SAH_BINS planes
+// along the axis the centers spread most on, by the surface area heuristic; falls back to
+// the median when every center lands on one side.
+int CollisionWorld::BuildNode(int begin, int end, int parent, int depth) {
+    int index = static_cast<int>(nodes.size());
+    nodes.push_back({ glm::vec3(0.0f), begin, glm::vec3(0.0f), end - begin });
+    parents.push_back(parent);
+    int count = end - begin;
+    if (count <= LEAF_SIZE || depth >= MAX_DEPTH - 1) return index;
+
+    auto centroid = [this](int item) { return (items[item].min + items[item].max) * 0.5f; };
+    glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+    for (int i = begin; i < end; ++i) {
+        glm::vec3 c = centroid(order[i]);
+        low = glm::min(low, c);
+        high = glm::max(high, c);
+    }
+    glm::vec3 spread = high - low;
+    int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+
+    int mid = begin;
+    if (spread[axis] > 0.0f) {
+        float scale = SAH_BINS / spread[axis];
+        auto bin = [&](int item) { return std::min(SAH_BINS - 1, static_cast<int>((centroid(item)[axis] - low[axis]) * scale)); };
+        int binCount[SAH_BINS] = {};
+        glm::vec3 binMin[SAH_BINS], binMax[SAH_BINS];
+        std::fill(binMin, binMin + SAH_BINS, glm::vec3(FLT_MAX));
+        std::fill(binMax, binMax + SAH_BINS, glm::vec3(-FLT_MAX));
+        for (int i = begin; i < end; ++i) {
+            int b = bin(order[i]);
+            binCount[b]++;
+            binMin[b] = glm::min(binMin[b], items[order[i]].min);
+            binMax[b] = glm::max(binMax[b], items[order[i]].max);
+        }
+        // Cost of the right side of each plane, swept from the right
+        float rightCost[SAH_BINS] = {};
+        glm::vec3 sideMin(FLT_MAX), sideMax(-FLT_MAX);
+        int sideCount = 0;
+        for (int b = SAH_BINS - 1; b > 0; --b) {
+            sideMin = glm::min(sideMin, binMin[b]);
+            sideMax = glm::max(sideMax, binMax[b]);
+            sideCount += binCount[b];
+            rightCost[b] = sideCount > 0 ? sideCount * Area(sideMin, sideMax) : 0.0f;
+        }
+        sideMin = glm::vec3(FLT_MAX);
+        sideMax = glm::vec3(-FLT_MAX);
+        sideCount = 0;
+        int split = 0;
+        float bestCost = FLT_MAX;
+        for (int b = 1; b < SAH_BINS; ++b) {
+            sideMin = glm::min(sideMin, binMin[b - 1]);
+            sideMax = glm::max(sideMax, binMax[b - 1]);
+            sideCount += binCount[b - 1];
+            float cost = (sideCount > 0 ? sideCount * Area(sideMin, sideMax) : 0.0f) + rightCost[b];
+            if (sideCount > 0 && sideCount < count && cost < bestCost) {
+                bestCost = cost;
+                split = b;
+            }
+        }
+        if (split > 0) mid = static_cast<int>(std::partition(order.begin() + begin, order.begin() + end, [&](int item) { return bin(item) < split; }) - order.begin());
+    }
+    if (mid == begin || mid == end) {
+        mid = begin + count / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                         [&](int a, int b) { return centroid(a)[axis] < centroid(b)[axis]; });
+    }
+
+    BuildNode(begin, mid, index, depth + 1);
+    int right = BuildNode(mid, end, index, depth + 1);
+    nodes[index].first = right;
+    nodes[index].count = -1;
+    return index;
+}
+
+// Bounds of a leaf's items, or of an inner node's children
+void CollisionWorld::FitNode(int i) {
+    Node& node = nodes[i];
+    if (node.count >= 0) {
+        node.min = glm::vec3(FLT_MAX);
+        node.max = glm::vec3(-FLT_MAX);
+        for (int k = node.first; k < node.first + node.count; ++k) {
+            node.min = glm::min(node.min, items[k].min);
+            node.max = glm::max(node.max, items[k].max);
+        }
+    }
+    else {
+        node.min = glm::min(nodes[i + 1].min, nodes[node.first].min);
+        node.max = glm::max(nodes[i + 1].max, nodes[node.first].max);
+    }
+}
+
+void CollisionWorld::Prepare() {
+    if (!built) {
+        Build();
+        return;
+    }
+    if (refitAll) {
+        cost = 0.0f;
+        for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i) {
+            FitNode(i);
+            cost += Area(nodes[i].min, nodes[i].max);
+        }
+    }
+    else {
+        for (int leaf : movedLeaves) {
+            for (int i = leaf; i >= 0; i = parents[i]) {
+                glm::vec3 oldMin = nodes[i].min, oldMax = nodes[i].max;
+                FitNode(i);
+                cost += Area(nodes[i].min, nodes[i].max) - Area(oldMin, oldMax);
+                // Nothing above changes either
+                if (nodes[i].min == oldMin && nodes[i].max == oldMax) break;
+            }
+        }
+    }
+    movedLeaves.clear();
+    refitAll = false;
+    if (cost > REBUILD_RATIO * builtCost) {
+        Build();
+        rebuilds++;
+    }
+}
+
+bool CollisionWorld::Raycast(const glm::vec3& origin, const glm::vec3& direction, CollisionHit& hit) {
+    Prepare();
+    hit = CollisionHit();
+    Traverse(origin, direction, hit, false);
+    return hit.kind != CollisionHit::NONE;
+}
+
+bool CollisionWorld::Occluded(const glm::vec3& from, const glm::vec3& to) {
+    glm::vec3 offset = to - from;
+    float distance = glm::length(offset);
+    if (distance <= 0.0f) return false;
+    return Occluded(from, offset / distance, distance);
+}
+
+bool CollisionWorld::Occluded(const glm::vec3& origin, const glm::vec3& direction, float distance) {
+    Prepare();
+    CollisionHit hit;
+    hit.t = distance;
+    Traverse(origin, direction, hit, true);
+    return hit.kind == CollisionHit::BOX;
+}
+
+void CollisionWorld::Traverse(const glm::vec3& origin, const glm::vec3& direction, CollisionHit& hit, bool boxesOnly) {
+    if (nodes.empty()) return;
+    // A zero component would make 0 * inf a NaN where the origin lies on a slab plane
+    glm::vec3 inverse;
+    for (int axis = 0; axis < 3; ++axis) {
+        float d = direction[axis];
+        inverse[axis] = 1.0f / (std::fabs(d) > 1e-12f ? d : std::copysign(1e-12f, d));
+    }
+
+    struct Entry {
+        int node;
+        float t;
+    };
+    Entry stack[MAX_DEPTH];
+    int size = 0;
+    float t;
+    if (!Slab(nodes[0].min, nodes[0].max, origin, inverse, hit.t, t)) return;
+    stack[size++] = { 0, t };
+
+    while (size > 0) {
+        Entry entry = stack[--size];
+        // A closer hit may have turned up since the node was pushed
+        if (entry.t > hit.t) continue;
+        const Node& node = nodes[entry.node];
+
+        if (node.count < 0) {
+            int near = entry.node + 1, far = node.first;
+            float tNear, tFar;
+            bool hitNear = Slab(nodes[near].min, nodes[near].max, origin, inverse, hit.t, tNear);
+            bool hitFar = Slab(nodes[far].min, nodes[far].max, origin, inverse, hit.t, tFar);
+            if (hitNear && hitFar && tFar < tNear) {
+                std::swap(near, far);
+                std::swap(tNear, tFar);
+            }
+            // The nearer child goes on top, so it is walked first
+            if (hitFar) stack[size++] = { far, tFar };
+            if (hitNear) stack[size++] = { near, tNear };
+            continue;
+        }
+
+        for (int k = node.first; k < node.first + node.count; ++k) {
+            const Item& item = items[k];
+            if (item.ref < 0) {
+                if (Slab(item.min, item.max, origin, inverse, hit.t, t) && Closer(CollisionHit::BOX, ~item.ref, t, hit)) {
+                    hit.kind = CollisionHit::BOX;
+                    hit.id = ~item.ref;
+                    hit.t = t;
+                    if (boxesOnly) return;
+                }
+                continue;
+            }
+            if (boxesOnly) continue;
+
+            // Same arithmetic as the ray kernels, so a target is hit at the same t
+            const Sphere& sphere = spheres[item.ref];
+            glm::vec3 oc = origin - sphere.center;
+            float b = oc.x * direction.x + oc.y * direction.y + oc.z * direction.z;
+            float c = oc.x * oc.x + oc.y * oc.y + oc.z * oc.z - sphere.radius * sphere.radius;
+            float discriminant = b * b - c;
+            if (discriminant < 0.0f) continue;
+            float root = std::sqrt(discriminant);
+            float tNear = -b - root;
+            t = tNear > 0.0f ? tNear : -b + root;
+            if (t > 0.0f && Closer(CollisionHit::SPHERE, item.ref, t, hit)) {
+                hit.kind = CollisionHit::SPHERE;
+                hit.id = item.ref;
+                hit.t = t;
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <vector>
+
+// What a ray query hit
+struct CollisionHit {
+    enum Kind { NONE, BOX, SPHERE };
+    Kind kind = NONE;
+    int id = -1;       // Index among the boxes or among the spheres, in the order they were added
+    float t = FLT_MAX; // Distance along the ray
+};
+
+// Static axis-aligned boxes and moving spheres in one bounding volume hierarchy, so a ray
+// finds the nearest thing in its way, level geometry included, in time logarithmic in the
+// number of objects. A sphere's box in the tree is grown by a margin: moving inside it
+// (a target on its path) leaves the tree alone. A sphere that leaves it (a respawn) is
+// moved to the leaf its new box enlarges least, and the next query refits the two leaves'
+// paths up to the root. Should that still loosen the tree to twice its built cost, the
+// query rebuilds it.
+class CollisionWorld {
+public:
+    int AddBox(const glm::vec3& min, const glm::vec3& max);
+    int AddSphere(const glm::vec3& center, float radius, float margin = 0.0f);
+    void MoveSphere(int id, const glm::vec3& center);
+    // Builds the tree over everything added so far; queries call it when objects were added
+    void Build();
+
+    // Nearest box or sphere the ray hits at t > 0, or NONE. direction must be normalized.
+    // A ray that starts inside a box hits it at t = 0.
+    bool Raycast(const glm::vec3& origin, const glm::vec3& direction, CollisionHit& hit);
+    // True if a box lies between the two points
+    bool Occluded(const glm::vec3& from, const glm::vec3& to);
+    // True if the ray hits a box at t <= distance, so it would win a tie with a sphere hit
+    // there. direction must be normalized.
+    bool Occluded(const glm::vec3& origin, const glm::vec3& direction, float distance);
+
+    int BoxCount() const { return static_cast<int>(boxes.size()); }
+    int SphereCount() const { return static_cast<int>(spheres.size()); }
+    int NodeCount() const { return static_cast<int>(nodes.size()); }
+    int Rebuilds() const { return rebuilds; }
+
+private:
+    // A box or a sphere's grown box; ref is the sphere id, or ~id for a box
+    struct Item {
+        glm::vec3 min, max;
+        int ref;
+    };
+
+    // Children of an inner node are the next node and node first. A leaf holds count items
+    // from items[first], in slots running up to the next leaf's.
+    struct Node {
+        glm::vec3 min;
+        int first;
+        glm::vec3 max;
+        int count; // -1 for an inner node
+    };
+
+    struct Sphere {
+        glm::vec3 center;
+        float radius;
+        glm::vec3 anchor; // Center of its item's box
+        float margin;
+        int item;
+    };
+
+    static const int LEAF_SIZE = 4;
+    static const int LEAF_SLOTS = 8; // Room in each leaf for spheres moving in
+    static const int SAH_BINS = 12;
+    static const int MAX_DEPTH = 64;
+    static constexpr float REBUILD_RATIO = 2.0f;
+
+    // Leaf slots once built, then anything added since
+    std::vector<Item> items;
+    int slotCount = 0;
+    std::vector<int> slotLeaves; // Leaf of each slot
+    std::vector<Item> sorted;
+    std::vector<int> order; // Item permutation while building
+    std::vector<Node> nodes;
+    std::vector<int> parents; // Of each node; -1 for the root
+    std::vector<int> boxes;   // Item of each box
+    std::vector<Sphere> spheres;
+    std::vector<int> movedLeaves; // Leaves whose items changed since the last query
+    bool built = false;
+    bool refitAll = false; // Too many moved leaves to refit one path at a time
+    float cost = 0.0f;     // Summed surface area of the nodes
+    float builtCost = 0.0f;
+    int rebuilds = 0;
+
+    void Prepare();
+    int BuildNode(int begin, int end, int parent, int depth);
+    void FitNode(int node);
+    // Points the item's box or sphere at the slot it now occupies
+    void Claim(int slot);
+    void Moved(int leaf);
+    // Walks the tree front to back; boxesOnly stops at the first box closer than hit.t
+    void Traverse(const glm::vec3& origin, const glm::vec3& direction, CollisionHit& hit, bool boxesOnly);
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+// Shared by the SIMD kernels: AIM_SIMD_X86 is defined on x86-64, where SSE2 is always
+// available and AVX2 paths are compiled per function with AIM_TARGET_AVX2 and picked at
+// runtime with CpuHasAvx2.
+#if defined(__x86_64__) || defined(_M_X64)
+#define AIM_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AIM_TARGET_AVX2
+#else
+#define AIM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+inline bool CpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
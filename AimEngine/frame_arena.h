@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that lives for one frame: Allocate bumps an offset and Reset
+// frees everything at once. A frame that needs more than the block holds gets the rest
+// from the heap, and the next Reset grows the block to fit, so a steady workload stops
+// touching the heap after its first few frames.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity = 0) { Grow(capacity); }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Uninitialized room for count objects. Nothing is destroyed on Reset, so only types
+    // without a destructor to run belong here.
+    template <typename T>
+    T* Allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "frame arena memory is never destroyed");
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // alignment must be a power of two no larger than BLOCK_ALIGNMENT
+    void* Allocate(size_t size, size_t alignment) {
+        size_t start = (used + alignment - 1) & ~(alignment - 1);
+        if (start + size <= capacity) {
+            used = start + size;
+            return block.get() + start;
+        }
+        // Overflow pieces are allocated whole and reported in the frame's total
+        overflow.emplace_back(new (std::align_val_t(BLOCK_ALIGNMENT)) unsigned char[size ? size : 1]);
+        overflowBytes += (size + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+        return overflow.back().get();
+    }
+
+    // Frees everything allocated since the last Reset; pointers into the arena go stale
+    void Reset() {
+        if (!overflow.empty()) {
+            Grow(used + overflowBytes);
+            overflow.clear();
+            overflowBytes = 0;
+        }
+        used = 0;
+    }
+
+    size_t Used() const { return used + overflowBytes; }
+    size_t Capacity() const { return capacity; }
+
+    // Allocations are aligned to at most a cache line
+    static const size_t BLOCK_ALIGNMENT = 64;
+
+private:
+    struct AlignedDelete {
+        void operator()(unsigned char* p) const { ::operator delete[](p, std::align_val_t(BLOCK_ALIGNMENT)); }
+    };
+    using Block = std::unique_ptr<unsigned char[], AlignedDelete>;
+
+    Block block;
+    size_t capacity = 0;
+    size_t used = 0;
+    std::vector<Block> overflow;
+    size_t overflowBytes = 0;
+
+    // Only between frames: the old block's contents are not kept
+    void Grow(size_t size) {
+        if (size <= capacity) return;
+        // Headroom so a frame slightly bigger than the last does not overflow again
+        capacity = std::max(size + size / 4, capacity * 2);
+        block.reset(new (std::align_val_t(BLOCK_ALIGNMENT)) unsigned char[capacity]);
+    }
+};
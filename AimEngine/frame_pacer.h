@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+// Caps the frame rate by starting each frame as late as it can. Waiting after a frame
+// (as a blocking swap does) shows input that was read a whole frame earlier; waiting
+// before it and starting only as long before the deadline as recent frames took means the
+// frame reads the newest input and is submitted just in time. The wait sleeps while the
+// start is far off and spins through the last stretch, because a sleep can wake late by a
+// scheduler tick; both the frame work and the oversleep are learned as frames go by.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 0 turns pacing off: WaitForFrameStart returns at once
+    void SetCap(double fps) {
+        period = fps > 0.0 ? 1.0 / fps : 0.0;
+        deadline = Clock::now();
+    }
+
+    double Cap() const { return period > 0.0 ? 1.0 / period : 0.0; }
+
+    // Blocks until the next frame should start: its deadline minus the expected work
+    void WaitForFrameStart() {
+        if (period > 0.0) Wait(deadline - Duration(workEstimate + WORK_MARGIN));
+        frameStart = Clock::now();
+    }
+
+    // Call once the frame's work is submitted, before presenting it
+    void FrameSubmitted() {
+        Clock::time_point now = Clock::now();
+        workEstimate = std::max(Seconds(now - frameStart), workEstimate * DECAY);
+        if (period <= 0.0) return;
+        deadline += Duration(period);
+        // After a stall, start again from now instead of rushing frames to catch up
+        if (deadline < now) deadline = now + Duration(period);
+    }
+
+    // What the pacer has learned, for display
+    double WorkEstimateMs() const { return 1000.0 * workEstimate; }
+    double OversleepMs() const { return 1000.0 * oversleep; }
+
+private:
+    // Added to the work estimate so an ordinary slower frame still makes its deadline
+    static constexpr double WORK_MARGIN = 0.0005;
+    // Estimates follow the slowest recent value and forget it over a few hundred frames
+    static constexpr double DECAY = 0.99;
+
+    double period = 0.0;
+    Clock::time_point deadline = Clock::now();
+    Clock::time_point frameStart = Clock::now();
+    double workEstimate = 0.0;
+    double oversleep = 0.001; // Start by assuming a millisecond-grained sleep
+
+    static double Seconds(Clock::duration duration) { return std::chrono::duration<double>(duration).count(); }
+    static Clock::duration Duration(double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    void Wait(Clock::time_point until) {
+        for (;;) {
+            Clock::time_point now = Clock::now();
+            double remaining = Seconds(until - now);
+            if (remaining <= 0.0) return;
+            if (remaining > oversleep) {
+                double request = remaining - oversleep;
+                std::this_thread::sleep_for(Duration(request));
+                oversleep = std::max(Seconds(Clock::now() - now) - request, oversleep * DECAY);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
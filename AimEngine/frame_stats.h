@@ -0,0 +1,46 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+// Rolling frame-time percentiles over the most recent frames
+class FrameTimeStats {
+public:
+    struct Summary {
+        double p50 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+        int frames = 0;
+    };
+
+    void Add(double ms) {
+        samples[next] = ms;
+        next = (next + 1) % WINDOW;
+        count = std::min(count + 1, WINDOW);
+    }
+
+    // O(WINDOW); meant for a few calls a second, not every frame
+    Summary Compute() const {
+        Summary summary;
+        summary.frames = count;
+        if (count == 0) return summary;
+
+        scratch.assign(samples, samples + count);
+        auto at = [this](double p) {
+            size_t index = std::min(static_cast<size_t>(p * (scratch.size() - 1) + 0.5), scratch.size() - 1);
+            std::nth_element(scratch.begin(), scratch.begin() + index, scratch.end());
+            return scratch[index];
+        };
+        summary.p50 = at(0.50);
+        summary.p99 = at(0.99);
+        summary.max = *std::max_element(scratch.begin(), scratch.end());
+        return summary;
+    }
+
+private:
+    static const int WINDOW = 512;
+
+    double samples[WINDOW] = {};
+    int next = 0;
+    int count = 0;
+    mutable std::vector<double> scratch;
+};
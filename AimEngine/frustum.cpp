@@ -0,0 +1,158 @@
+#include "frustum.h"
+#include "cpu_features.h"
+
+namespace {
+
+bool scalarOnly = false;
+
+inline const float* SphereAt(const void* spheres, size_t strideBytes, int i) {
+    return reinterpret_cast<const float*>(static_cast<const char*>(spheres) + i * strideBytes);
+}
+
+// Same operation order as the SIMD paths so all of them agree on spheres touching a plane
+inline bool SphereInside(const Frustum& frustum, const float* sphere) {
+    for (const glm::vec4& plane : frustum.planes) {
+        float distance = plane.x * sphere[0] + plane.y * sphere[1] + plane.z * sphere[2] + plane.w;
+        if (distance < -sphere[3]) return false;
+    }
+    return true;
+}
+
+int CullScalar(const Frustum& frustum, const void* spheres, size_t strideBytes, int begin, int count, int* visible, int written) {
+    for (int i = begin; i < count; ++i) {
+        visible[written] = i;
+        written += SphereInside(frustum, SphereAt(spheres, strideBytes, i));
+    }
+    return written;
+}
+
+#ifdef AIM_SIMD_X86
+
+const bool hasAvx2 = CpuHasAvx2();
+
+AIM_TARGET_AVX2 int CullAvx2(const Frustum& frustum, const void* spheres, size_t strideBytes, int count, int* visible) {
+    __m256 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p) {
+        px[p] = _mm256_set1_ps(frustum.planes[p].x);
+        py[p] = _mm256_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm256_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm256_set1_ps(frustum.planes[p].w);
+    }
+
+    int written = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Spheres i..i+3 in the low halves, i+4..i+7 in the high halves, then a 4x4
+        // transpose within each half gives x, y, z and radius across all eight lanes
+        __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(SphereAt(spheres, strideBytes, i))), _mm_loadu_ps(SphereAt(spheres, strideBytes, i + 4)), 1);
+        __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(SphereAt(spheres, strideBytes, i + 1))), _mm_loadu_ps(SphereAt(spheres, strideBytes, i + 5)), 1);
+        __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(SphereAt(spheres, strideBytes, i + 2))), _mm_loadu_ps(SphereAt(spheres, strideBytes, i + 6)), 1);
+        __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(SphereAt(spheres, strideBytes, i + 3))), _mm_loadu_ps(SphereAt(spheres, strideBytes, i + 7)), 1);
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+        __m256 t1 = _mm256_unpacklo_ps(r2, r3);
+        __m256 t2 = _mm256_unpackhi_ps(r0, r1);
+        __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+        __m256 x = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 y = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 z = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2)));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], x), _mm256_mul_ps(py[p], y)), _mm256_mul_ps(pz[p], z)), pw[p]);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+        }
+
+        // Branchless compaction: always write the index, advance only past visible ones
+        int mask = _mm256_movemask_ps(inside);
+        for (int lane = 0; lane < 8; ++lane) {
+            visible[written] = i + lane;
+            written += (mask >> lane) & 1;
+        }
+    }
+    return CullScalar(frustum, spheres, strideBytes, i, count, visible, written);
+}
+
+int CullSse2(const Frustum& frustum, const void* spheres, size_t strideBytes, int count, int* visible) {
+    __m128 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p) {
+        px[p] = _mm_set1_ps(frustum.planes[p].x);
+        py[p] = _mm_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+
+    int written = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(SphereAt(spheres, strideBytes, i));
+        __m128 y = _mm_loadu_ps(SphereAt(spheres, strideBytes, i + 1));
+        __m128 z = _mm_loadu_ps(SphereAt(spheres, strideBytes, i + 2));
+        __m128 radius = _mm_loadu_ps(SphereAt(spheres, strideBytes, i + 3));
+        _MM_TRANSPOSE4_PS(x, y, z, radius);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)), _mm_mul_ps(pz[p], z)), pw[p]);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; ++lane) {
+            visible[written] = i + lane;
+            written += (mask >> lane) & 1;
+        }
+    }
+    return CullScalar(frustum, spheres, strideBytes, i, count, visible, written);
+}
+
+#endif
+
+}
+
+Frustum Frustum::FromViewProjection(const glm::mat4& m) {
+    // glm is column-major: row r of the matrix is (m[0][r], m[1][r], m[2][r], m[3][r])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0;
+    frustum.planes[1] = row3 - row0;
+    frustum.planes[2] = row3 + row1;
+    frustum.planes[3] = row3 - row1;
+    frustum.planes[4] = row3 + row2;
+    frustum.planes[5] = row3 - row2;
+    for (glm::vec4& plane : frustum.planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const {
+    const float sphere[4] = { center.x, center.y, center.z, radius };
+    return SphereInside(*this, sphere);
+}
+
+int CullSpheres(const Frustum& frustum, const void* spheres, size_t strideBytes, int count, int* visible) {
+#ifdef AIM_SIMD_X86
+    if (!scalarOnly) {
+        if (hasAvx2) return CullAvx2(frustum, spheres, strideBytes, count, visible);
+        return CullSse2(frustum, spheres, strideBytes, count, visible);
+    }
+#endif
+    return CullScalar(frustum, spheres, strideBytes, 0, count, visible, 0);
+}
+
+const char* CullKernelName() {
+#ifdef AIM_SIMD_X86
+    if (!scalarOnly) return hasAvx2 ? "avx2" : "sse2";
+#endif
+    return "scalar";
+}
+
+void SetCullKernelScalarOnly(bool enabled) {
+    scalarOnly = enabled;
+}
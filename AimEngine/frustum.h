@@ -0,0 +1,30 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// View frustum as six planes (left, right, bottom, top, near, far). Each plane is
+// (normal, distance) with the normal pointing inside and normalized, so plane·(p, 1) is
+// the signed distance of p from it.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    // Planes of the clip volume of projection * view (Gribb and Hartmann)
+    static Frustum FromViewProjection(const glm::mat4& viewProjection);
+
+    // False only when the sphere is entirely outside one plane. Spheres near a corner
+    // can pass while outside, which costs a draw but never drops a visible one.
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+// Writes the indices of the spheres that pass Frustum::IntersectsSphere to visible, in
+// order, and returns how many there are. Sphere i is read as four floats (x, y, z,
+// radius) at spheres + i * strideBytes, which is how SphereInstance is laid out. Uses
+// AVX2 (8 spheres per iteration) or SSE2 (4) when the CPU has them; every path gives
+// the same result.
+int CullSpheres(const Frustum& frustum, const void* spheres, size_t strideBytes, int count, int* visible);
+
+// Name of the kernel CullSpheres dispatches to ("avx2", "sse2" or "scalar")
+const char* CullKernelName();
+
+// Forces the scalar fallback, for benchmarking and for checking the SIMD paths
+void SetCullKernelScalarOnly(bool enabled);
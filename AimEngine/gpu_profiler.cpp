@@ -0,0 +1,42 @@
+#include "gpu_profiler.h"
+#include <glad/glad.h>
+#include <algorithm>
+
+void GpuProfiler::Init() {
+    glGenQueries(FRAMES_IN_FLIGHT * MAX_PHASES, &queries[0][0]);
+}
+
+void GpuProfiler::BeginFrame() {
+    frame = (frame + 1) % FRAMES_IN_FLIGHT;
+
+    // This slot was submitted FRAMES_IN_FLIGHT - 1 frames ago; its results are almost
+    // always ready, and a phase that is not is dropped rather than waited for
+    for (int i = 0; i < phaseCount[frame]; ++i) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(queries[frame][i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 durationNs = 0;
+        glGetQueryObjectui64v(queries[frame][i], GL_QUERY_RESULT, &durationNs);
+        const Phase& phase = phases[frame][i];
+        uint64_t startNs = std::max(phase.cpuStartNs, gpuCursorNs);
+        Profiler::RecordOnTrack(Profiler::GPU_TRACK, phase.name, startNs, durationNs);
+        gpuCursorNs = startNs + durationNs;
+    }
+    phaseCount[frame] = 0;
+}
+
+bool GpuProfiler::Begin(const char* name) {
+    if (open || !Profiler::IsCapturing() || phaseCount[frame] == MAX_PHASES) return false;
+    int index = phaseCount[frame]++;
+    phases[frame][index] = { name, Profiler::NowNs() };
+    glBeginQuery(GL_TIME_ELAPSED, queries[frame][index]);
+    open = true;
+    return true;
+}
+
+void GpuProfiler::End() {
+    if (!open) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    open = false;
+}
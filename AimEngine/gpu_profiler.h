@@ -0,0 +1,55 @@
+#pragma once
+#include "profiler.h"
+#include <cstdint>
+
+// GL_TIME_ELAPSED queries around draw phases. Results are read back FRAMES_IN_FLIGHT
+// frames later so the CPU never waits on the GPU, and land on the profiler's GPU track.
+// A time-elapsed query has no start time, so each phase is placed at its CPU submit time
+// (or right after the previous phase, whichever is later).
+class GpuProfiler {
+public:
+    void Init();
+    // Resolves the oldest frame's queries; call once at the start of a frame
+    void BeginFrame();
+    // Time-elapsed queries cannot nest, so Begin returns false (and records nothing) while
+    // another phase is open, or when no capture is running
+    bool Begin(const char* name);
+    void End();
+
+private:
+    static const int FRAMES_IN_FLIGHT = 4;
+    static const int MAX_PHASES = 16;
+
+    struct Phase {
+        const char* name;
+        uint64_t cpuStartNs;
+    };
+
+    unsigned int queries[FRAMES_IN_FLIGHT][MAX_PHASES] = {};
+    Phase phases[FRAMES_IN_FLIGHT][MAX_PHASES];
+    int phaseCount[FRAMES_IN_FLIGHT] = {};
+    int frame = 0;
+    bool open = false;
+    uint64_t gpuCursorNs = 0;
+};
+
+class GpuProfileScope {
+public:
+    GpuProfileScope(GpuProfiler& profiler, const char* name) : profiler(profiler), active(profiler.Begin(name)) {}
+    ~GpuProfileScope() {
+        if (active) profiler.End();
+    }
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    GpuProfiler& profiler;
+    bool active;
+};
+
+#ifdef AIM_PROFILE
+#define AIM_PROFILE_GPU_SCOPE(profiler, name) GpuProfileScope AIM_PROFILE_CONCAT(gpuProfileScope, __LINE__)(profiler, name)
+#else
+#define AIM_PROFILE_GPU_SCOPE(profiler, name) ((void)0)
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+// Offscreen OpenGL 3.3 core context with no window or display server. Uses EGL on
+// Mesa's surfaceless platform (llvmpipe when there is no GPU) and renders into an FBO
+// so Renderer can run unchanged on CI machines.
+class HeadlessContext {
+public:
+    bool Init(int width, int height);
+    void Shutdown();
+    // Blocks until the GPU has finished every submitted command
+    void Finish();
+    const char* GetRendererName();
+    // GL entry point by name, as glad was loaded with
+    static void* ProcAddress(const char* name);
+
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+private:
+    void* display = nullptr;
+    void* context = nullptr;
+    unsigned int fbo = 0, colorBuffer = 0, depthBuffer = 0;
+    int width = 0, height = 0;
+};
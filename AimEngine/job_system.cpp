@@ -0,0 +1,204 @@
+#include "job_system.h"
+#include "profiler.h"
+#include <iostream>
+
+namespace {
+
+std::atomic<uint32_t> nextSystemId{ 1 };
+
+// The calling thread's queue in each of the last few systems it used, so a thread that
+// goes back and forth between systems registers once in each. Ids are never reused, so an
+// entry for a destroyed system is just never matched again.
+struct LocalQueueCache {
+    static const int SYSTEMS = 8;
+    uint32_t systems[SYSTEMS] = {};
+    int queues[SYSTEMS] = {};
+    int next = 0; // Entry to overwrite next, the oldest
+
+    int* Find(uint32_t system) {
+        for (int i = 0; i < SYSTEMS; ++i) {
+            if (systems[i] == system) return &queues[i];
+        }
+        return nullptr;
+    }
+
+    void Add(uint32_t system, int queue) {
+        systems[next] = system;
+        queues[next] = queue;
+        next = (next + 1) % SYSTEMS;
+    }
+};
+thread_local LocalQueueCache localQueues;
+
+}
+
+bool JobSystem::WorkQueue::Push(const Job& job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail - head == QUEUE_CAPACITY) return false;
+    jobs[tail++ % QUEUE_CAPACITY] = job;
+    return true;
+}
+
+bool JobSystem::WorkQueue::Pop(Job& job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail == head) return false;
+    job = jobs[--tail % QUEUE_CAPACITY];
+    return true;
+}
+
+bool JobSystem::WorkQueue::Steal(Job& job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail == head) return false;
+    job = jobs[head++ % QUEUE_CAPACITY];
+    return true;
+}
+
+JobSystem::JobSystem(int workerCount) : id(nextSystemId++) {
+    if (workerCount < 0) {
+        workerCount = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    workerCount = std::min(workerCount, MAX_QUEUES / 2);
+    for (int i = 0; i < workerCount; ++i) {
+        int queue = RegisterQueue();
+        workers.emplace_back(&JobSystem::WorkerLoop, this, queue);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::Submit(Job job) {
+    if (job.counter) job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+    Enqueue(job);
+}
+
+void JobSystem::Submit(Job job, JobCounter& dependency) {
+    if (job.counter) job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if (dependency.pending.load(std::memory_order_acquire) > 0) {
+            Continuation* continuation;
+            {
+                std::lock_guard<std::mutex> poolLock(continuationMutex);
+                continuation = continuations.Create(Continuation{ job, nullptr });
+            }
+            if (dependency.lastContinuation) dependency.lastContinuation->next = continuation;
+            else dependency.firstContinuation = continuation;
+            dependency.lastContinuation = continuation;
+            return;
+        }
+    }
+    Enqueue(job);
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    while (counter.pending.load(std::memory_order_acquire) > 0) {
+        Job job;
+        if (TakeJob(job)) Execute(job);
+        else std::this_thread::yield();
+    }
+    // The thread that finished the last job may still hold the lock; the counter must
+    // outlive that
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+int JobSystem::LocalQueue() {
+    if (int* queue = localQueues.Find(id)) return *queue;
+    int queue = RegisterQueue();
+    localQueues.Add(id, queue);
+    return queue;
+}
+
+int JobSystem::RegisterQueue() {
+    std::lock_guard<std::mutex> lock(registerMutex);
+    int index = queueCount.load(std::memory_order_relaxed);
+    if (index == MAX_QUEUES) {
+        std::cout << "ERROR::JOBS::TOO_MANY_THREADS\n" << "Jobs from further threads run inline" << std::endl;
+        return -1;
+    }
+    queues[index].reset(new WorkQueue());
+    queueCount.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+void JobSystem::Enqueue(const Job& job) {
+    int queue = LocalQueue();
+    if (queue < 0 || !queues[queue]->Push(job)) {
+        // No room: running it now is always correct, just not parallel
+        Execute(job);
+        return;
+    }
+    queued.fetch_add(1);
+    if (sleepers.load() > 0) {
+        // Taking the lock orders this against a worker that is about to sleep
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wake.notify_one();
+    }
+}
+
+bool JobSystem::TakeJob(Job& job) {
+    int local = LocalQueue();
+    if (local >= 0 && queues[local]->Pop(job)) {
+        queued.fetch_sub(1);
+        return true;
+    }
+    int count = queueCount.load(std::memory_order_acquire);
+    for (int k = 1; k <= count; ++k) {
+        int victim = (std::max(local, 0) + k) % count;
+        if (victim != local && queues[victim]->Steal(job)) {
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::Execute(const Job& job) {
+    job.function(job.context, job.begin, job.end);
+    JobCounter* counter = job.counter;
+    if (!counter) return;
+
+    Continuation* ready = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ready = counter->firstContinuation;
+            counter->firstContinuation = nullptr;
+            counter->lastContinuation = nullptr;
+        }
+    }
+    while (ready) {
+        Job next = ready->job;
+        Continuation* following = ready->next;
+        {
+            std::lock_guard<std::mutex> poolLock(continuationMutex);
+            continuations.Destroy(ready);
+        }
+        ready = following;
+        Enqueue(next);
+    }
+}
+
+void JobSystem::WorkerLoop(int queue) {
+    AIM_PROFILE_THREAD("Job worker");
+    localQueues.Add(id, queue);
+    while (running.load(std::memory_order_relaxed)) {
+        Job job;
+        if (TakeJob(job)) {
+            Execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1);
+        wake.wait(lock, [this] { return !running || queued.load() > 0; });
+        sleepers.fetch_sub(1);
+    }
+}
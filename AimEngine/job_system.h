@@ -0,0 +1,140 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "pool.h"
+
+class JobCounter;
+
+// A range of work: function(context, begin, end). Plain data so queuing never allocates.
+struct Job {
+    void (*function)(void* context, int begin, int end);
+    void* context;
+    int begin, end;
+    JobCounter* counter; // Decremented once the job has run; may be null
+};
+
+// A job waiting on a counter, queued in submission order
+struct Continuation {
+    Job job;
+    Continuation* next;
+};
+
+// Number of jobs still to run. Wait on it to block until they are done; jobs submitted
+// with it as their dependency become runnable when it reaches zero. Reuse a counter only
+// after waiting on it.
+class JobCounter {
+public:
+    int Pending() const { return pending.load(std::memory_order_acquire); }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> pending{ 0 };
+    std::mutex mutex;
+    Continuation* firstContinuation = nullptr;
+    Continuation* lastContinuation = nullptr;
+};
+
+// Work-stealing scheduler. Every thread that submits work gets its own deque: it pushes
+// and pops at one end (newest first, while the data is still in cache) and idle threads
+// steal from the other end (oldest, usually the biggest piece). Waiting threads run jobs
+// instead of blocking, so any thread may submit and wait, including from inside a job.
+class JobSystem {
+public:
+    // Worker threads in addition to the threads that submit work; -1 for one less than
+    // the hardware thread count
+    explicit JobSystem(int workerCount = -1);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Threads that run jobs: the workers plus the caller of Wait or ParallelFor
+    int ThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    void Submit(Job job);
+    // The job becomes runnable once dependency reaches zero
+    void Submit(Job job, JobCounter& dependency);
+
+    // Runs queued jobs on the calling thread until counter reaches zero
+    void Wait(JobCounter& counter);
+
+    // Calls body(begin, end) on ranges covering [0, count) across all threads, in pieces of
+    // at least grain items, and returns when every piece has run. Ranges are fixed by count
+    // and ThreadCount only, so per-range results can be merged in a repeatable order.
+    template <typename Body>
+    void ParallelFor(int count, int grain, const Body& body) {
+        if (count <= 0) return;
+        int size = RangeSize(count, grain);
+        if (size >= count) {
+            body(0, count);
+            return;
+        }
+        JobCounter counter;
+        for (int begin = size; begin < count; begin += size) {
+            Submit({ &RunBody<Body>, const_cast<Body*>(&body), begin, std::min(count, begin + size), &counter });
+        }
+        body(0, std::min(count, size));
+        Wait(counter);
+    }
+
+    // Items per ParallelFor range: range k is [k * size, min(count, (k + 1) * size)), so
+    // callers can keep per-range results in slot begin / size
+    int RangeSize(int count, int grain) const {
+        if (ThreadCount() == 1 || count <= 0) return std::max(count, 1);
+        grain = std::max(grain, 1);
+        // A few ranges per thread so a slow thread does not hold up the rest
+        int ranges = std::max(1, std::min((count + grain - 1) / grain, ThreadCount() * RANGES_PER_THREAD));
+        return (count + ranges - 1) / ranges;
+    }
+
+private:
+    static const int MAX_QUEUES = 64;
+    static const int QUEUE_CAPACITY = 1024;
+    static const int RANGES_PER_THREAD = 4;
+
+    // A deque behind a lock: jobs are coarse ranges, so the lock is almost never contended
+    struct WorkQueue {
+        std::mutex mutex;
+        Job jobs[QUEUE_CAPACITY];
+        uint32_t head = 0; // Next to steal
+        uint32_t tail = 0; // Next free slot
+
+        bool Push(const Job& job);
+        bool Pop(Job& job);
+        bool Steal(Job& job);
+    };
+
+    const uint32_t id; // Tells this system apart from earlier ones in per-thread caches
+    std::unique_ptr<WorkQueue> queues[MAX_QUEUES];
+    std::atomic<int> queueCount{ 0 };
+    std::mutex registerMutex;
+
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{ true };
+    std::atomic<int> queued{ 0 };
+    std::atomic<int> sleepers{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    // Continuations come from a pool so a steady frame graph never allocates
+    std::mutex continuationMutex;
+    Pool<Continuation> continuations;
+
+    template <typename Body>
+    static void RunBody(void* context, int begin, int end) {
+        (*static_cast<const Body*>(context))(begin, end);
+    }
+
+    int LocalQueue();
+    int RegisterQueue();
+    void Enqueue(const Job& job);
+    bool TakeJob(Job& job);
+    void Execute(const Job& job);
+    void WorkerLoop(int queue);
+};
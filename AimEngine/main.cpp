@@ -3,44 +3,155 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <cstdio>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <memory>
 #include "renderer.h"
+#include "program_cache.h"
+#include "frame_pacer.h"
+#include "resolution_controller.h"
 #include "camera.h"
-#include "target_manager.h"
+#include "simulation.h"
+#include "arena.h"
+#include "recording.h"
+#include "random.h"
+#include "profiler.h"
+#include "frame_stats.h"
+#include "job_system.h"
+#include "shot_log.h"
+#include "mesh_loader.h"
+#include "allocation_counter.h"
 
 // Function declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void window_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
-glm::vec3 GetRayFromMouse(float mouseX, float mouseY, const glm::mat4& projection, const glm::mat4& view);
+void renderLoop(GLFWwindow* window, Simulation& sim, const SimConfig& simConfig, JobSystem& jobs, const SphereLodMeshes& sphereMeshes);
+void buildSimulation(void* context, int begin, int end);
+void buildSphereMeshes(void* context, int begin, int end);
 
 // Screen dimensions
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
 
-// Target parameters
-const float TARGET_MIN_X = -5.0f;
-const float TARGET_MAX_X = 5.0f;
-const float TARGET_MIN_Y = 1.0f;
-const float TARGET_MAX_Y = 6.0f;
-const float TARGET_Z = -10.0f;
-const float TARGET_RADIUS = 0.25f;
-const int TARGET_COUNT = 10;
+// Simulation tick rate, independent of the frame rate
+const int SIM_TICK_RATE = 1000;
+
+// Frame cap of the low-latency mode unless --frame-cap gives one
+const double DEFAULT_FRAME_CAP = 240.0;
 
 // Globals
-Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
-bool keys[1024];
-float lastX = SCR_WIDTH / 2.0f;
-float lastY = SCR_HEIGHT / 2.0f;
-bool firstMouse = true;
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
-bool mouseLeftClick = false;
-TargetManager targetManager(TARGET_COUNT, TARGET_MIN_X, TARGET_MAX_X, TARGET_MIN_Y, TARGET_MAX_Y, TARGET_Z, TARGET_RADIUS);
-
-int main()
+Simulation* simulation = nullptr; // Owned by main; the callbacks only forward input to it
+std::atomic<bool> useInstancing{ true }; // Toggled with I to compare against one draw per target
+std::atomic<bool> renderRunning{ true };
+std::atomic<int> framebufferWidth{ SCR_WIDTH }, framebufferHeight{ SCR_HEIGHT };
+// Cursor positions arrive in window coordinates, which can differ from the framebuffer's
+// pixels (high-DPI displays) and from the simulation's screen (a resized window)
+std::atomic<int> windowWidth{ SCR_WIDTH }, windowHeight{ SCR_HEIGHT };
+std::mutex titleMutex;
+char windowTitle[512] = "";
+bool titleChanged = false;
+std::atomic<bool> captureRequested{ false }; // Toggled with P; the render thread starts and stops the capture
+std::atomic<bool> lowLatency{ false }; // Toggled with L: paced frames that latch input late, against vsync
+double frameCap = DEFAULT_FRAME_CAP;
+// GPU time per frame that dynamic resolution holds to; negative follows the frame period of
+// the pacing mode (the cap, or the monitor's refresh rate with vsync) and 0 turns it off
+double frameBudgetMs = -1.0;
+int refreshRate = 60;
+
+// Where a profiler capture is written (open in chrome://tracing or ui.perfetto.dev)
+const char* TRACE_PATH = "aim_trace.json";
+
+// Linked shader programs from the last launch; --program-cache picks another file
+const char* programCachePath = "aim_programs.bin";
+
+// Launch to first frame by phase, printed once the first frame is on screen, for comparing
+// cold starts (empty program cache) with warm ones
+struct StartupTimes
 {
+    std::chrono::steady_clock::time_point launch;
+    double windowMs = 0.0;   // GLFW and the window, on the main thread
+    double targetsMs = 0.0;  // Simulation and target layout, on a worker meanwhile
+    double meshesMs = 0.0;   // Sphere LOD geometry, on a worker meanwhile
+    double programsMs = 0.0; // Shaders compiled or loaded from the cache, on the render thread
+    int cachedPrograms = 0, programs = 0;
+} startup;
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Custom models, loaded in the background from launch on and uploaded by the render thread
+// once they are ready; until then targets are spheres and the arena has only its boxes
+MeshLoader meshLoader;
+int targetModelRequest = -1, arenaModelRequest = -1;
+
+// Built on the job system while the main thread creates the window
+struct StartupWork
+{
+    const SimConfig* simConfig;
+    std::unique_ptr<Simulation> sim;
+    SphereLodMeshes sphereMeshes;
+};
+
+// Usage: AimEngine [--seed N] [--record <file>] [--shots <file>] [--motion static|strafe|circle|spline] [--targets N] [--sweep MS]
+//                  [--program-cache <file>] [--frame-cap FPS] [--frame-budget MS]
+//                  [--target-model <obj or aimmesh>] [--arena-model <obj or aimmesh>]
+int main(int argc, char** argv)
+{
+    startup.launch = std::chrono::steady_clock::now();
+    // Unseeded sessions are still reproducible from a recording, which stores the seed
+    uint64_t seed = Rng::ClockSeed();
+    const char* recordPath = nullptr;
+    const char* shotLogPath = nullptr;
+    SimConfig simConfig;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--seed") == 0) seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--record") == 0) recordPath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--shots") == 0) shotLogPath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--motion") == 0 && !ParseMotionPattern(argv[i + 1], simConfig.targetMotion))
+            std::cout << "ERROR::ARGS::UNKNOWN_MOTION\n" << argv[i + 1] << std::endl;
+        else if (std::strcmp(argv[i], "--targets") == 0) simConfig.targetCount = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--sweep") == 0) simConfig.sweepSeconds = std::max(0.0f, (float)std::atof(argv[i + 1]) / 1000.0f);
+        else if (std::strcmp(argv[i], "--program-cache") == 0) programCachePath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--frame-cap") == 0)
+        {
+            // Starts in the low-latency mode
+            frameCap = std::max(1.0, std::atof(argv[i + 1]));
+            lowLatency = true;
+        }
+        else if (std::strcmp(argv[i], "--frame-budget") == 0) frameBudgetMs = std::max(0.0, std::atof(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--target-model") == 0) targetModelRequest = meshLoader.Load(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--arena-model") == 0) arenaModelRequest = meshLoader.Load(argv[i + 1]);
+    }
+
+    // Camera, targets and hit registration run on their own thread
+    simConfig.tickRate = SIM_TICK_RATE;
+    simConfig.screenWidth = (float)SCR_WIDTH;
+    simConfig.screenHeight = (float)SCR_HEIGHT;
+    simConfig.seed = seed;
+    // Worker threads shared by the simulation and the renderer for large per-frame passes.
+    // Until the window is up they lay out the targets and build the sphere meshes.
+    JobSystem jobs;
+    StartupWork work;
+    work.simConfig = &simConfig;
+    JobCounter startupJobs;
+    jobs.Submit({ buildSimulation, &work, 0, 1, &startupJobs });
+    jobs.Submit({ buildSphereMeshes, &work, 0, 1, &startupJobs });
+
     // Initialize GLFW
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -55,89 +166,300 @@ int main()
     if (window == NULL)
     {
         std::cout << "Failed to create GLFW window\n";
+        jobs.Wait(startupJobs);
         glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
+    startup.windowMs = MillisecondsSince(startup.launch);
+    // The window manager may not grant the size asked for
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    window_size_callback(window, width, height);
+    glfwGetFramebufferSize(window, &width, &height);
+    framebuffer_size_callback(window, width, height);
+    if (const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor()))
+        refreshRate = std::max(1, mode->refreshRate);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowSizeCallback(window, window_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetKeyCallback(window, key_callback);
 
-    // Load GLAD
+    jobs.Wait(startupJobs);
+    Simulation& sim = *work.sim;
+    sim.SetJobSystem(&jobs);
+    simulation = &sim;
+
+    InputRecorder recorder;
+    if (recordPath && recorder.Open(recordPath, simConfig))
+        sim.SetRecorder(&recorder);
+    ShotLog shotLog;
+    if (shotLogPath && shotLog.Open(shotLogPath, seed))
+        sim.SetShotLog(&shotLog);
+    sim.Start();
+
+    // Rendering gets its own thread so this one only waits on the window system and
+    // timestamps every input event as it arrives, not once per rendered frame
+    std::thread renderThread(renderLoop, window, std::ref(sim), std::cref(simConfig), std::ref(jobs), std::cref(work.sphereMeshes));
+
+    // Main loop
+    while (!glfwWindowShouldClose(window))
+    {
+        glfwWaitEventsTimeout(0.1);
+        processInput(window);
+
+        std::lock_guard<std::mutex> lock(titleMutex);
+        if (titleChanged)
+        {
+            glfwSetWindowTitle(window, windowTitle);
+            titleChanged = false;
+        }
+    }
+
+    renderRunning = false;
+    renderThread.join();
+    sim.Stop();
+    simulation = nullptr;
+    recorder.Close(sim.CurrentTick());
+    shotLog.Close();
+    glfwTerminate();
+    return 0;
+}
+
+
+// Startup jobs, run while the window is created
+void buildSimulation(void* context, int begin, int end)
+{
+    auto start = std::chrono::steady_clock::now();
+    StartupWork& work = *static_cast<StartupWork*>(context);
+    work.sim.reset(new Simulation(*work.simConfig));
+    startup.targetsMs = MillisecondsSince(start);
+}
+
+void buildSphereMeshes(void* context, int begin, int end)
+{
+    auto start = std::chrono::steady_clock::now();
+    Renderer::BuildSphereMeshes(static_cast<StartupWork*>(context)->sphereMeshes);
+    startup.meshesMs = MillisecondsSince(start);
+}
+
+// Owns the GL context: draws the newest simulation snapshot until the window closes
+void renderLoop(GLFWwindow* window, Simulation& sim, const SimConfig& simConfig, JobSystem& jobs, const SphereLodMeshes& sphereMeshes)
+{
+    glfwMakeContextCurrent(window);
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
         std::cout << "Failed to initialize GLAD\n";
-        return -1;
+        glfwSetWindowShouldClose(window, true);
+        glfwPostEmptyEvent();
+        return;
     }
 
-    // Setup renderer
+    // Setup renderer; programs linked from source are saved for the next launch right away
+    auto programsStart = std::chrono::steady_clock::now();
+    ProgramCache programCache;
+    programCache.Open(programCachePath, (GLADloadproc)glfwGetProcAddress);
     Renderer renderer;
-    renderer.Init();
+    renderer.Init(&programCache, &sphereMeshes);
+    renderer.SetJobSystem(&jobs);
+    programCache.Save();
+    startup.programsMs = MillisecondsSince(programsStart);
+    startup.cachedPrograms = programCache.Hits();
+    startup.programs = programCache.Hits() + programCache.Misses();
+    bool firstFrame = true;
 
-    // Main loop
-    while (!glfwWindowShouldClose(window))
-    {
-        float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+    AIM_PROFILE_THREAD("Render");
 
-        processInput(window);
-        camera.ProcessKeyboard(keys, deltaTime);
+    int arenaMesh = -1;
+    int viewportWidth = SCR_WIDTH, viewportHeight = SCR_HEIGHT;
+    FrameTimeStats frameTimes;
+    float lastFrame = (float)glfwGetTime();
+    float statsStart = lastFrame;
+    // Heap allocations by this thread over the last frame, and the most in one frame since
+    // the title was last updated; a warmed-up game should show 0
+    uint64_t frameStartAllocations = AllocationCounter::ThreadAllocations();
+    uint64_t maxFrameAllocations = 0;
 
-        renderer.BeginFrame();
+    // Vsync lets the swap pace frames, so a frame shows input read before the previous swap
+    // returned. The low-latency mode turns vsync off and has the pacer start each frame just
+    // in time for the cap, then latches the newest camera the simulation has published.
+    FramePacer pacer;
+    bool pacing = !lowLatency.load(); // Forces the mode to be applied on the first frame
+    FrameTimeStats inputToPresent; // Newest mouse movement in a frame to its swap returning
+    double lastPresentedMouse = -1.0;
 
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    // Dynamic resolution: the scene is drawn at a scale of the framebuffer's size picked from
+    // recent GPU frame times, then scaled up to fill it
+    ResolutionController resolution(0.0, Renderer::MIN_RENDER_SCALE);
 
-        // Draw targets
-        for (auto& target : targetManager.targets)
+    while (renderRunning.load())
+    {
+        if (lowLatency.load() != pacing)
         {
-            if (!target.hit)
+            pacing = lowLatency.load();
+            glfwSwapInterval(pacing ? 0 : 1);
+            pacer.SetCap(pacing ? frameCap : 0.0);
+            inputToPresent = FrameTimeStats();
+        }
+        pacer.WaitForFrameStart();
+
+        float currentFrame = (float)glfwGetTime();
+        frameTimes.Add(1000.0 * (currentFrame - lastFrame));
+        lastFrame = currentFrame;
+        uint64_t allocations = AllocationCounter::ThreadAllocations();
+        maxFrameAllocations = std::max(maxFrameAllocations, allocations - frameStartAllocations);
+        frameStartAllocations = allocations;
+
+#ifdef AIM_PROFILE
+        // P starts a capture and P again writes it out
+        Profiler::Collect();
+        if (captureRequested.load() != Profiler::IsCapturing())
+        {
+            if (captureRequested.load())
+            {
+                Profiler::BeginCapture();
+            }
+            else
             {
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, target.position);
-                model = glm::scale(model, glm::vec3(target.radius));
-                renderer.DrawSphere(model, view, projection);
+                Profiler::EndCapture();
+                if (Profiler::WriteChromeTrace(TRACE_PATH))
+                    std::cout << "Wrote " << Profiler::CapturedEvents() << " events to " << TRACE_PATH << " (" << Profiler::DroppedEvents() << " dropped)\n";
             }
         }
+#endif
+        AIM_PROFILE_SCOPE("Frame");
+
+        // Models that finished loading since the last frame go up to the GPU here
+        LoadedMesh loaded;
+        while (meshLoader.TakeLoaded(loaded))
+        {
+            if (!loaded.mesh) continue;
+            auto uploadStart = std::chrono::steady_clock::now();
+            int mesh = renderer.AddMesh(*loaded.mesh);
+            double uploadMs = MillisecondsSince(uploadStart);
+            if (loaded.request == targetModelRequest) renderer.SetTargetMesh(mesh);
+            if (loaded.request == arenaModelRequest) arenaMesh = mesh;
+            std::printf("Model %s: %d vertices, %d triangles, %s in %.1f ms, uploaded in %.1f ms\n", loaded.path.c_str(),
+                loaded.mesh->VertexCount(), loaded.mesh->IndexCount() / 3, loaded.fromCache ? "read from cache" : "loaded", loaded.loadMs, uploadMs);
+        }
 
-        // Draw the Cube (as ground)
-        glm::mat4 groundModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.5f, 0.0f));
-        groundModel = glm::scale(groundModel, glm::vec3(10.0f, 0.1f, 10.0f)); // Scale to a plane
-        renderer.DrawCube(groundModel, view, projection, glm::vec3(0.3f, 0.3f, 1.0f));
+        if (framebufferWidth.load() != viewportWidth || framebufferHeight.load() != viewportHeight)
+        {
+            viewportWidth = framebufferWidth.load();
+            viewportHeight = framebufferHeight.load();
+            renderer.SetViewport(viewportWidth, viewportHeight);
+        }
 
-        // Draw a wall
-        glm::mat4 wallModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.75f, 5.0f));
-        wallModel = glm::scale(wallModel, glm::vec3(10.0f, 5.0f, 0.2f));
-        renderer.DrawCube(wallModel, view, projection, glm::vec3(0.8f, 0.2f, 0.2f)); // Red wall
+        // Render one tick behind the newest snapshot and blend it with the tick before. The
+        // low-latency mode shows the camera of the newest tick instead, since blending delays it.
+        const SimSnapshot& snapshot = sim.LatestSnapshot();
+        float alpha = glm::clamp((float)((sim.Now() - snapshot.time) / sim.TickInterval()), 0.0f, 1.0f);
+        float cameraAlpha = pacing ? 1.0f : alpha;
+        double frameMouseTime = snapshot.lastMouseTime;
 
-        // Handle mouse click
-        if (mouseLeftClick)
+        // Draw calls, culling, frame-time percentiles, score and shot latency, twice a second.
+        // The window title can only be set from the main thread, which picks this up.
+        if (currentFrame - statsStart >= 0.5f)
         {
-            mouseLeftClick = false;
+            FrameTimeStats::Summary frameSummary = frameTimes.Compute();
+            FrameTimeStats::Summary latencySummary = inputToPresent.Compute();
+            char pacingName[48];
+            if (pacing) std::snprintf(pacingName, sizeof(pacingName), "%.0f fps cap, late latch", pacer.Cap());
+            else std::snprintf(pacingName, sizeof(pacingName), "vsync");
+            std::lock_guard<std::mutex> lock(titleMutex);
+            std::snprintf(windowTitle, sizeof(windowTitle), "Aim Trainer - OpenGL | %s | %d draws | %d visible, %d culled | frame %.2f/%.2f/%.2f ms p50/p99/max | render %dx%d, gpu %.1f ms | %s, input to present %.1f/%.1f ms p50/p99 | %d/%d hits (%d swept), %.0f%% | TTK %.0f/%.0f ms p50/p90 | shot latency %.2f ms avg, %.2f ms max | heap %llu/frame, %llu ticks%s",
+                useInstancing ? "instanced" : "per-target", renderer.GetStats().drawCalls,
+                renderer.GetStats().visible, renderer.GetStats().culled,
+                frameSummary.p50, frameSummary.p99, frameSummary.max,
+                renderer.GetStats().renderWidth, renderer.GetStats().renderHeight, std::max(0.0, renderer.GetGpuFrameMs()), pacingName, latencySummary.p50, latencySummary.p99,
+                snapshot.hits, snapshot.shots, snapshot.sweptHits,
+                100.0 * snapshot.shotStats.accuracy, 1000.0 * snapshot.shotStats.timeToKillP50, 1000.0 * snapshot.shotStats.timeToKillP90,
+                1000.0 * snapshot.registrationLatencyMean, 1000.0 * snapshot.registrationLatencyMax,
+                (unsigned long long)maxFrameAllocations, (unsigned long long)snapshot.allocatingTicks,
+                Profiler::IsCapturing() ? " | capturing" : "");
+            titleChanged = true;
+            statsStart = currentFrame;
+            maxFrameAllocations = 0;
+        }
+
+        resolution.SetBudget(frameBudgetMs >= 0.0 ? frameBudgetMs : 1000.0 / (pacing ? pacer.Cap() : refreshRate));
+        renderer.SetRenderScale(resolution.Update(renderer.GetGpuFrameMs(), renderer.GetGpuFrameScale()));
+        renderer.BeginFrame();
 
-            // Get ray from camera to mouse position
-            glm::vec3 rayOrigin = camera.Position;
-            glm::vec3 rayDirection = GetRayFromMouse(lastX, lastY, projection, view);
+        Camera viewCamera(glm::mix(snapshot.previousCameraPosition, snapshot.cameraPosition, cameraAlpha));
+        viewCamera.Yaw = glm::mix(snapshot.previousYaw, snapshot.yaw, cameraAlpha);
+        viewCamera.Pitch = glm::mix(snapshot.previousPitch, snapshot.pitch, cameraAlpha);
+        glm::mat4 view = viewCamera.GetViewMatrix();
+        glm::mat4 projection = glm::perspective(glm::radians(simConfig.fovDegrees), (float)SCR_WIDTH / (float)SCR_HEIGHT, simConfig.nearPlane, simConfig.farPlane);
+        renderer.SetCamera(view, projection);
 
-            // Check for hits
-            if (targetManager.CheckHits(rayOrigin, rayDirection))
+        // Draw targets
+        if (useInstancing)
+        {
+            SphereInstance* sphereInstances = renderer.FrameMemory().Allocate<SphereInstance>(snapshot.targets.size());
+            int instanceCount = 0;
+            for (const TargetState& target : snapshot.targets)
+            {
+                if (!target.hit)
+                    sphereInstances[instanceCount++] = { glm::mix(target.previousPosition, target.position, alpha), target.radius, glm::vec3(1.0f, 0.3f, 0.3f) };
+            }
+            renderer.DrawSpheresInstanced(sphereInstances, instanceCount);
+        }
+        else
+        {
+            for (const TargetState& target : snapshot.targets)
             {
-                targetManager.ResetHitTargets(TARGET_MIN_X, TARGET_MAX_X, TARGET_MIN_Y, TARGET_MAX_Y, TARGET_Z);
+                if (!target.hit)
+                {
+                    glm::mat4 model = glm::mat4(1.0f);
+                    model = glm::translate(model, glm::mix(target.previousPosition, target.position, alpha));
+                    model = glm::scale(model, glm::vec3(target.radius));
+                    renderer.DrawSphere(model);
+                }
             }
         }
 
+        // Ground and walls; the simulation's shots collide with the same boxes
+        for (const ArenaBox& box : ARENA_BOXES)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), box.center);
+            renderer.DrawCube(glm::scale(model, box.size), box.color);
+        }
+        // Scenery only: shots still collide with the boxes alone
+        if (arenaMesh >= 0)
+            renderer.DrawMesh(arenaMesh, glm::mat4(1.0f), glm::vec3(0.6f, 0.6f, 0.6f));
+
         renderer.EndFrame();
+        pacer.FrameSubmitted();
+
+        AIM_PROFILE_SCOPE("SwapBuffers");
         glfwSwapBuffers(window);
-        glfwPollEvents();
+
+        // From the newest mouse movement in the frame; frames with no new movement are skipped
+        if (frameMouseTime > lastPresentedMouse)
+        {
+            inputToPresent.Add(1000.0 * (sim.Now() - frameMouseTime));
+            lastPresentedMouse = frameMouseTime;
+        }
+
+        if (firstFrame)
+        {
+            std::printf("Startup: first frame after %.1f ms (window %.1f ms; targets %.1f ms and meshes %.1f ms on workers meanwhile; programs %.1f ms, %d/%d from cache)\n",
+                MillisecondsSince(startup.launch), startup.windowMs, startup.targetsMs, startup.meshesMs, startup.programsMs,
+                startup.cachedPrograms, startup.programs);
+            firstFrame = false;
+        }
     }
 
-    glfwTerminate();
-    return 0;
+#ifdef AIM_PROFILE
+    if (Profiler::IsCapturing())
+    {
+        Profiler::EndCapture();
+        Profiler::WriteChromeTrace(TRACE_PATH);
+    }
+#endif
 }
 
-
 // Handle input
 void processInput(GLFWwindow* window)
 {
@@ -145,62 +467,64 @@ void processInput(GLFWwindow* window)
         glfwSetWindowShouldClose(window, true);
 }
 
-// Resize callback
+// Resize callback; the render thread owns the context and applies the viewport
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    framebufferWidth = width;
+    framebufferHeight = height;
+}
+
+void window_size_callback(GLFWwindow* window, int width, int height)
+{
+    // Minimized windows report 0
+    if (width <= 0 || height <= 0) return;
+    windowWidth = width;
+    windowHeight = height;
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-    if (key >= 0 && key < 1024)
+    if (key == 'I' && action == GLFW_PRESS)
+        useInstancing = !useInstancing.load();
+    if (key == 'P' && action == GLFW_PRESS)
+        captureRequested = !captureRequested.load();
+    if (key == 'L' && action == GLFW_PRESS)
+        lowLatency = !lowLatency.load();
+
+    if (simulation && (action == GLFW_PRESS || action == GLFW_RELEASE))
     {
-        if (action == GLFW_PRESS)
-            keys[key] = true;
-        else if (action == GLFW_RELEASE)
-            keys[key] = false;
+        InputEvent event = {};
+        event.type = InputEvent::KEY;
+        event.time = simulation->Now();
+        event.key = key;
+        event.pressed = action == GLFW_PRESS;
+        simulation->PushInput(event);
     }
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
-    if (firstMouse)
-    {
-        lastX = (float)xpos;
-        lastY = (float)ypos;
-        firstMouse = false;
-    }
-
-    float xoffset = (float)(xpos - lastX);
-    float yoffset = (float)(ypos - lastY);
-    lastX = (float)xpos;
-    lastY = (float)ypos;
+    if (!simulation) return;
 
-    camera.ProcessMouseMovement(xoffset, yoffset);
+    InputEvent event = {};
+    event.type = InputEvent::MOUSE_MOVE;
+    event.time = simulation->Now();
+    event.rawX = (float)xpos;
+    event.rawY = (float)ypos;
+    // Into the simulation's screen, which the scene is stretched over at whatever window
+    // size and render resolution, so the ray through the cursor is the one drawn under it
+    event.x = (float)(xpos * SCR_WIDTH / windowWidth.load());
+    event.y = (float)(ypos * SCR_HEIGHT / windowHeight.load());
+    simulation->PushInput(event);
 }
+
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
-    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+    if (simulation && button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
     {
-        mouseLeftClick = true;
+        InputEvent event = {};
+        event.type = InputEvent::CLICK;
+        event.time = simulation->Now();
+        simulation->PushInput(event);
     }
 }
-// Function to create a ray from mouse position
-glm::vec3 GetRayFromMouse(float mouseX, float mouseY, const glm::mat4& projection, const glm::mat4& view) {
-    // Convert mouse coordinates to normalized device coordinates
-    float x = (2.0f * mouseX) / SCR_WIDTH - 1.0f;
-    float y = 1.0f - (2.0f * mouseY) / SCR_HEIGHT;
-    float z = 1.0f;
-
-    // Create ray in clip space
-    glm::vec4 rayClip = glm::vec4(x, y, -1.0f, 1.0f);
-
-    // Convert to eye space
-    glm::vec4 rayEye = glm::inverse(projection) * rayClip;
-    rayEye = glm::vec4(rayEye.x, rayEye.y, -1.0f, 0.0f);
-
-    // Convert to world space
-    glm::vec3 rayWorld = glm::vec3(glm::inverse(view) * rayEye);
-    return glm::normalize(rayWorld);
-}
-
@@ -0,0 +1,188 @@
+#include "mapped_file.h"
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::Open(const char* path) {
+    Close();
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED\n" << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(handle, &fileSize);
+    size = static_cast<size_t>(fileSize.QuadPart);
+    file = handle;
+    if (size == 0) return true;
+
+    mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping) {
+        data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED\n" << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED\n" << path << std::endl;
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (view != MAP_FAILED) {
+        madvise(view, size, MADV_SEQUENTIAL);
+        data = static_cast<const unsigned char*>(view);
+    }
+#endif
+    if (!data) {
+        std::cout << "ERROR::MAPPED_FILE::MAP_FAILED\n" << path << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    mapping = nullptr;
+    file = nullptr;
+#else
+    if (data) munmap(const_cast<unsigned char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool MappedAppendFile::Create(const char* path) {
+    Close();
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        std::cout << "ERROR::MAPPED_FILE::CREATE_FAILED\n" << path << std::endl;
+        return false;
+    }
+    file = handle;
+#else
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cout << "ERROR::MAPPED_FILE::CREATE_FAILED\n" << path << std::endl;
+        return false;
+    }
+#endif
+    this->path = path;
+    size = 0;
+    return true;
+}
+
+void MappedAppendFile::Close() {
+#ifdef _WIN32
+    if (file) CloseHandle(file);
+    file = nullptr;
+#else
+    if (fd >= 0) close(fd);
+    fd = -1;
+#endif
+    size = 0;
+}
+
+bool MappedAppendFile::IsOpen() const {
+#ifdef _WIN32
+    return file != nullptr;
+#else
+    return fd >= 0;
+#endif
+}
+
+unsigned char* MappedAppendFile::Map(uint64_t offset, size_t length) {
+    if (!IsOpen() || offset % MAP_ALIGNMENT != 0) return nullptr;
+    uint64_t end = offset + length;
+    void* view = nullptr;
+#ifdef _WIN32
+    // The mapping object fixes the file size, so each growth makes a new one; the view
+    // keeps it alive after the handle is closed
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, static_cast<DWORD>(std::max(size, end) >> 32),
+                                        static_cast<DWORD>(std::max(size, end)), NULL);
+    if (mapping) {
+        view = MapViewOfFile(mapping, FILE_MAP_WRITE, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), length);
+        CloseHandle(mapping);
+    }
+#else
+    if (end > size && ftruncate(fd, static_cast<off_t>(end)) != 0) {
+        std::cout << "ERROR::MAPPED_FILE::GROW_FAILED\n" << path << std::endl;
+        return nullptr;
+    }
+    view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(offset));
+    if (view == MAP_FAILED) view = nullptr;
+#endif
+    if (!view) {
+        std::cout << "ERROR::MAPPED_FILE::MAP_FAILED\n" << path << std::endl;
+        return nullptr;
+    }
+    size = std::max(size, end);
+    return static_cast<unsigned char*>(view);
+}
+
+void MappedAppendFile::Unmap(unsigned char* view, size_t length) {
+    if (!view) return;
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+#else
+    munmap(view, length);
+#endif
+}
+
+bool ReplacementFile::Open(const char* path) {
+    Discard();
+    this->path = path;
+    temporary = this->path + ".tmp";
+    file = std::fopen(temporary.c_str(), "wb");
+    return file != nullptr;
+}
+
+bool ReplacementFile::Commit() {
+    if (!file) return false;
+    bool written = !std::ferror(file);
+    written = std::fclose(file) == 0 && written;
+    file = nullptr;
+#ifdef _WIN32
+    // rename does not replace an existing file there
+    if (written) std::remove(path.c_str());
+#endif
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void ReplacementFile::Discard() {
+    if (!file) return;
+    std::fclose(file);
+    file = nullptr;
+    std::remove(temporary.c_str());
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Read-only memory mapping of a whole file. The OS pages it in on demand, so large
+// recordings are read without copying them into the heap first.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path);
+    void Close();
+
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+// Writable file that grows one mapped block at a time, for append-only logs. Only the blocks
+// being written are mapped, so memory use stays flat however long the file gets, and
+// whatever is written to a mapping survives a crash of the process.
+class MappedAppendFile {
+public:
+    // Block offsets must be multiples of this: the Windows allocation granularity, which is
+    // also a multiple of every page size
+    static const size_t MAP_ALIGNMENT = 65536;
+
+    MappedAppendFile() = default;
+    ~MappedAppendFile() { Close(); }
+    MappedAppendFile(const MappedAppendFile&) = delete;
+    MappedAppendFile& operator=(const MappedAppendFile&) = delete;
+
+    // Creates the file, replacing any old one
+    bool Create(const char* path);
+    void Close();
+    bool IsOpen() const;
+
+    // Grows the file to cover [offset, offset + size) if needed and maps that range;
+    // null on failure
+    unsigned char* Map(uint64_t offset, size_t size);
+    static void Unmap(unsigned char* view, size_t size);
+
+private:
+    std::string path;
+    uint64_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+// A file written whole and then swapped in for the old one: writes go to a temporary next to
+// it, which Commit renames over it, so an interrupted write never leaves a truncated file
+// behind. Destroyed without a Commit, the temporary is deleted and the old file kept.
+class ReplacementFile {
+public:
+    ReplacementFile() = default;
+    ~ReplacementFile() { Discard(); }
+    ReplacementFile(const ReplacementFile&) = delete;
+    ReplacementFile& operator=(const ReplacementFile&) = delete;
+
+    bool Open(const char* path);
+    std::FILE* Stream() const { return file; }
+    // False if a write or the rename failed; the old file is then left as it was
+    bool Commit();
+
+private:
+    std::string path;
+    std::string temporary;
+    std::FILE* file = nullptr;
+
+    void Discard();
+};
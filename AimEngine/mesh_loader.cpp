@@ -0,0 +1,262 @@
+#include "mesh_loader.h"
+#include "profiler.h"
+#include <cfloat>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+static const char MESH_MAGIC[4] = { 'A', 'I', 'M', 'M' };
+static const uint32_t MESH_VERSION = 1;
+// Appended to an OBJ's path for its baked copy
+static const char* BAKED_SUFFIX = ".aimmesh";
+
+// Fixed-width, little-endian, at the start of the file. Positions follow it, then indices,
+// both 4-byte aligned so the mapping can be used as arrays in place.
+struct MeshFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize; // Size and modification time of the OBJ it was baked from
+    int64_t sourceTime;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float min[3];
+    float max[3];
+};
+
+bool MeshAsset::Load(const char* path, bool bakeCache, bool& fromCache) {
+    fromCache = false;
+    vertices.clear();
+    indices.clear();
+
+    // A baked copy is only good for the OBJ it was made from
+    std::error_code error;
+    uint64_t sourceSize = std::filesystem::file_size(path, error);
+    int64_t sourceTime = error ? 0 : static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    std::string bakedPath = std::string(path) + BAKED_SUFFIX;
+    if (bakeCache && !error && std::filesystem::exists(bakedPath, error) && MapBaked(bakedPath.c_str(), true, sourceSize, sourceTime)) {
+        fromCache = true;
+        return true;
+    }
+
+    if (!file.Open(path)) return false;
+    if (file.Size() >= sizeof(MESH_MAGIC) && std::memcmp(file.Data(), MESH_MAGIC, sizeof(MESH_MAGIC)) == 0) {
+        return MapBaked(path, false, 0, 0);
+    }
+    if (!ParseObj(file.Data(), file.Size(), path)) return false;
+    // The arrays hold everything now
+    file.Close();
+    if (bakeCache) Bake(bakedPath.c_str(), sourceSize, sourceTime);
+    return true;
+}
+
+bool MeshAsset::MapBaked(const char* path, bool checkSource, uint64_t sourceSize, int64_t sourceTime) {
+    if (!file.Open(path)) return false;
+    MeshFileHeader header;
+    bool valid = file.Size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, file.Data(), sizeof(header));
+        valid = std::memcmp(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC)) == 0 && header.version == MESH_VERSION &&
+                header.indexCount % 3 == 0 &&
+                file.Size() - sizeof(header) >= (3ull * header.vertexCount + header.indexCount) * 4;
+    }
+    if (!valid) {
+        std::cout << "ERROR::MESH::BAD_FILE\n" << path << std::endl;
+        file.Close();
+        return false;
+    }
+    // Stale, not broken: the OBJ is parsed and baked again
+    if (checkSource && (header.sourceSize != sourceSize || header.sourceTime != sourceTime)) {
+        file.Close();
+        return false;
+    }
+
+    vertexData = reinterpret_cast<const float*>(file.Data() + sizeof(header));
+    indexData = reinterpret_cast<const uint32_t*>(vertexData + 3 * header.vertexCount);
+    vertexCount = static_cast<int>(header.vertexCount);
+    indexCount = static_cast<int>(header.indexCount);
+    min = glm::vec3(header.min[0], header.min[1], header.min[2]);
+    max = glm::vec3(header.max[0], header.max[1], header.max[2]);
+    // Indices are used by the GPU as they are, so one out of range is checked for here
+    for (int i = 0; i < indexCount; ++i) {
+        if (indexData[i] >= header.vertexCount) {
+            std::cout << "ERROR::MESH::BAD_FILE\n" << path << std::endl;
+            file.Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads positions (v) and faces (f) straight out of the mapping; texture coordinates,
+// normals, groups and materials are skipped. Face corners may be written v, v/vt, v//vn or
+// v/vt/vn, and negative numbers count back from the latest vertex.
+bool MeshAsset::ParseObj(const unsigned char* data, size_t size, const char* path) {
+    const char* p = reinterpret_cast<const char*>(data);
+    const char* end = p + size;
+    int line = 1;
+    auto fail = [&](const char* what) {
+        std::cout << "ERROR::MESH::" << what << "\n" << path << ":" << line << std::endl;
+        return false;
+    };
+    auto skipBlanks = [&] {
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    };
+    // Roughly 30 bytes per vertex line, and twice as many faces as vertices
+    vertices.reserve(size / 30 * 3);
+    indices.reserve(size / 30 * 6);
+
+    while (p < end) {
+        skipBlanks();
+        if (end - p >= 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            p += 2;
+            for (int axis = 0; axis < 3; ++axis) {
+                skipBlanks();
+                float value;
+                std::from_chars_result parsed = std::from_chars(p, end, value);
+                if (parsed.ec != std::errc()) return fail("BAD_VERTEX");
+                vertices.push_back(value);
+                p = parsed.ptr;
+            }
+        }
+        else if (end - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            p += 2;
+            // A polygon becomes a fan of triangles around its first corner
+            int64_t known = static_cast<int64_t>(vertices.size() / 3);
+            uint32_t first = 0, previous = 0;
+            int corners = 0;
+            for (skipBlanks(); p < end && *p != '\n' && *p != '\r' && *p != '#'; skipBlanks()) {
+                int64_t number;
+                std::from_chars_result parsed = std::from_chars(p, end, number);
+                if (parsed.ec != std::errc()) return fail("BAD_FACE");
+                p = parsed.ptr;
+                while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') ++p;
+                int64_t index = number > 0 ? number - 1 : known + number;
+                if (number == 0 || index < 0 || index >= known) return fail("BAD_INDEX");
+                if (corners >= 2) {
+                    indices.push_back(first);
+                    indices.push_back(previous);
+                    indices.push_back(static_cast<uint32_t>(index));
+                }
+                if (corners == 0) first = static_cast<uint32_t>(index);
+                previous = static_cast<uint32_t>(index);
+                corners++;
+            }
+            if (corners < 3) return fail("BAD_FACE");
+        }
+        while (p < end && *p != '\n') ++p;
+        if (p < end) {
+            ++p;
+            ++line;
+        }
+    }
+    if (indices.empty()) return fail("NO_TRIANGLES");
+
+    vertexData = vertices.data();
+    indexData = indices.data();
+    vertexCount = static_cast<int>(vertices.size() / 3);
+    indexCount = static_cast<int>(indices.size());
+    min = glm::vec3(FLT_MAX);
+    max = glm::vec3(-FLT_MAX);
+    for (int i = 0; i < vertexCount; ++i) {
+        glm::vec3 position(vertexData[3 * i], vertexData[3 * i + 1], vertexData[3 * i + 2]);
+        min = glm::min(min, position);
+        max = glm::max(max, position);
+    }
+    return true;
+}
+
+bool MeshAsset::Bake(const char* path, uint64_t sourceSize, int64_t sourceTime) const {
+    ReplacementFile baked;
+    if (!baked.Open(path)) {
+        std::cout << "ERROR::MESH::BAKE_FAILED\n" << path << std::endl;
+        return false;
+    }
+    MeshFileHeader header = {};
+    std::memcpy(header.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+    header.version = MESH_VERSION;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.vertexCount = static_cast<uint32_t>(vertexCount);
+    header.indexCount = static_cast<uint32_t>(indexCount);
+    for (int axis = 0; axis < 3; ++axis) {
+        header.min[axis] = min[axis];
+        header.max[axis] = max[axis];
+    }
+    std::fwrite(&header, sizeof(header), 1, baked.Stream());
+    std::fwrite(vertexData, sizeof(float), 3 * static_cast<size_t>(vertexCount), baked.Stream());
+    std::fwrite(indexData, sizeof(uint32_t), static_cast<size_t>(indexCount), baked.Stream());
+    if (!baked.Commit()) {
+        std::cout << "ERROR::MESH::BAKE_FAILED\n" << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+MeshLoader::~MeshLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+int MeshLoader::Load(const char* path, bool bakeCache) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Started on first use, so a game without custom models has no extra thread
+    if (!worker.joinable()) worker = std::thread(&MeshLoader::WorkerLoop, this);
+    int id = nextRequest++;
+    requests.push_back({ id, path, bakeCache });
+    inFlight++;
+    wake.notify_one();
+    return id;
+}
+
+bool MeshLoader::TakeLoaded(LoadedMesh& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (loaded.empty()) return false;
+    out = std::move(loaded.front());
+    loaded.pop_front();
+    return true;
+}
+
+void MeshLoader::Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return inFlight == 0; });
+}
+
+int MeshLoader::Pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return inFlight;
+}
+
+void MeshLoader::WorkerLoop() {
+    AIM_PROFILE_THREAD("Mesh loader");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !requests.empty(); });
+        if (stopping) return;
+        Request request = std::move(requests.front());
+        requests.pop_front();
+        lock.unlock();
+
+        LoadedMesh result;
+        result.request = request.id;
+        result.path = request.path;
+        {
+            AIM_PROFILE_SCOPE("Load mesh");
+            auto start = std::chrono::steady_clock::now();
+            result.mesh.reset(new MeshAsset());
+            if (!result.mesh->Load(request.path.c_str(), request.bakeCache, result.fromCache)) result.mesh.reset();
+            result.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        lock.lock();
+        loaded.push_back(std::move(result));
+        inFlight--;
+        finished.notify_all();
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "mapped_file.h"
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Triangle mesh in the renderer's vertex layout: three floats of position per vertex and
+// three indices per triangle. A baked mesh points straight into its mapped file, so
+// nothing is copied between the disk cache and the GPU upload; a parsed OBJ owns arrays.
+class MeshAsset {
+public:
+    MeshAsset() = default;
+    MeshAsset(const MeshAsset&) = delete;
+    MeshAsset& operator=(const MeshAsset&) = delete;
+
+    const float* Vertices() const { return vertexData; }
+    const uint32_t* Indices() const { return indexData; }
+    int VertexCount() const { return vertexCount; }
+    int IndexCount() const { return indexCount; }
+    const glm::vec3& Min() const { return min; }
+    const glm::vec3& Max() const { return max; }
+
+    // An OBJ file (positions and faces; polygons become fans) or a baked mesh, told apart by
+    // the baked format's magic. With bakeCache, an OBJ is read from path + ".aimmesh" when
+    // that was baked from the same file, and baked there otherwise.
+    bool Load(const char* path, bool bakeCache, bool& fromCache);
+    // Writes the mesh in the baked format; sourceSize and sourceTime identify the OBJ it came from
+    bool Bake(const char* path, uint64_t sourceSize, int64_t sourceTime) const;
+
+private:
+    MappedFile file;
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    const float* vertexData = nullptr;
+    const uint32_t* indexData = nullptr;
+    int vertexCount = 0;
+    int indexCount = 0;
+    glm::vec3 min = glm::vec3(0.0f), max = glm::vec3(0.0f);
+
+    // Maps a baked file; false if it is not one, or was baked from another source
+    bool MapBaked(const char* path, bool checkSource, uint64_t sourceSize, int64_t sourceTime);
+    bool ParseObj(const unsigned char* data, size_t size, const char* path);
+};
+
+// A finished load, failed or not
+struct LoadedMesh {
+    int request = -1;
+    std::string path;
+    std::unique_ptr<MeshAsset> mesh; // Null when the file could not be loaded
+    bool fromCache = false;          // Read from the baked cache instead of parsing the OBJ
+    double loadMs = 0.0;             // On the loader thread, from the request being picked up
+};
+
+// Loads meshes on a background thread, one file at a time in request order. The render
+// thread picks up finished meshes with TakeLoaded between frames and uploads them itself,
+// so a frame never waits on the disk or the parser.
+class MeshLoader {
+public:
+    MeshLoader() = default;
+    ~MeshLoader();
+    MeshLoader(const MeshLoader&) = delete;
+    MeshLoader& operator=(const MeshLoader&) = delete;
+
+    // Queues a file and returns its request number, which its LoadedMesh carries
+    int Load(const char* path, bool bakeCache = true);
+    // The oldest finished load, if any; never waits for one
+    bool TakeLoaded(LoadedMesh& out);
+    // Blocks until every queued file has finished loading
+    void Wait();
+    int Pending() const;
+
+private:
+    struct Request {
+        int id;
+        std::string path;
+        bool bakeCache;
+    };
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;     // Loader thread: a request arrived, or stop
+    std::condition_variable finished; // Wait: a load finished
+    std::deque<Request> requests;
+    std::deque<LoadedMesh> loaded;
+    int nextRequest = 0;
+    int inFlight = 0; // Queued or loading
+    bool stopping = false;
+    std::thread worker;
+
+    void WorkerLoop();
+};
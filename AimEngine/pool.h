@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed-size slots for objects that come and go often. Slots are carved from chunks that
+// are kept until the pool is destroyed and freed slots are reused first, so once the pool
+// has grown to the most objects ever alive at once it stops allocating. Not thread-safe;
+// destroy every object before the pool.
+template <typename T, size_t CHUNK_SLOTS = 256>
+class Pool {
+public:
+    Pool() = default;
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    template <typename... Args>
+    T* Create(Args&&... args) {
+        Slot* slot = freeList;
+        if (slot) freeList = slot->next;
+        else slot = NewSlot();
+        live++;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void Destroy(T* object) {
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = freeList;
+        freeList = slot;
+        live--;
+    }
+
+    size_t Live() const { return live; }
+    size_t Capacity() const { return chunks.size() * CHUNK_SLOTS; }
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    Slot* freeList = nullptr;
+    size_t chunkUsed = CHUNK_SLOTS; // Slots handed out from the newest chunk
+    size_t live = 0;
+
+    Slot* NewSlot() {
+        if (chunkUsed == CHUNK_SLOTS) {
+            chunks.emplace_back(new Slot[CHUNK_SLOTS]);
+            chunkUsed = 0;
+        }
+        return &chunks.back()[chunkUsed++];
+    }
+};
@@ -0,0 +1,141 @@
+#include "profiler.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Enough for a few frames of dense scopes between two Collect calls
+const size_t RING_CAPACITY = 8192;
+
+// Upper bound on a capture (32 bytes per event)
+const size_t MAX_CAPTURED_EVENTS = 4 << 20;
+
+namespace {
+
+struct ThreadRing {
+    SpscQueue<ProfileEvent, RING_CAPACITY> events;
+    uint32_t track;
+    std::string name;
+};
+
+std::atomic<bool> capturing{ false };
+std::atomic<uint64_t> dropped{ 0 };
+
+// Rings live until exit so a thread can end while its events are still being collected
+std::mutex ringsMutex;
+std::vector<std::unique_ptr<ThreadRing>> rings;
+
+std::vector<ProfileEvent> captured;
+
+const std::chrono::steady_clock::time_point clockEpoch = std::chrono::steady_clock::now();
+
+ThreadRing& LocalRing() {
+    thread_local ThreadRing* ring = nullptr;
+    if (!ring) {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.emplace_back(new ThreadRing());
+        ring = rings.back().get();
+        ring->track = static_cast<uint32_t>(rings.size()); // 0 is the GPU track
+        ring->name = "Thread " + std::to_string(ring->track);
+    }
+    return *ring;
+}
+
+// Names are string literals chosen in the source, but keep the JSON valid regardless
+void WriteJsonString(std::FILE* file, const char* text) {
+    std::fputc('"', file);
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') std::fputc('\\', file);
+        if (static_cast<unsigned char>(*c) >= 0x20) std::fputc(*c, file);
+    }
+    std::fputc('"', file);
+}
+
+}
+
+void Profiler::BeginCapture() {
+    captured.clear();
+    dropped = 0;
+    capturing = true;
+}
+
+void Profiler::EndCapture() {
+    capturing = false;
+    Collect();
+}
+
+bool Profiler::IsCapturing() {
+    return capturing.load(std::memory_order_relaxed);
+}
+
+uint64_t Profiler::NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - clockEpoch).count()) + 1;
+}
+
+void Profiler::SetThreadName(const char* name) {
+    ThreadRing& ring = LocalRing();
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    ring.name = name;
+}
+
+void Profiler::Record(const char* name, uint64_t startNs, uint64_t durationNs) {
+    ThreadRing& ring = LocalRing();
+    if (!ring.events.Push({ name, startNs, durationNs, ring.track })) dropped++;
+}
+
+void Profiler::RecordOnTrack(uint32_t track, const char* name, uint64_t startNs, uint64_t durationNs) {
+    if (!LocalRing().events.Push({ name, startNs, durationNs, track })) dropped++;
+}
+
+void Profiler::Collect() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    ProfileEvent event;
+    for (auto& ring : rings) {
+        while (ring->events.Pop(event)) {
+            if (captured.size() < MAX_CAPTURED_EVENTS) captured.push_back(event);
+            else dropped++;
+        }
+    }
+}
+
+bool Profiler::WriteChromeTrace(const char* path) {
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) {
+        std::printf("ERROR::PROFILER::TRACE_OPEN_FAILED\n%s\n", path);
+        return false;
+    }
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}", GPU_TRACK);
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (const auto& ring : rings) {
+            std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", ring->track);
+            WriteJsonString(file, ring->name.c_str());
+            std::fprintf(file, "}}");
+        }
+    }
+
+    // Complete ("X") events; the format wants microseconds
+    for (const ProfileEvent& event : captured) {
+        std::fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+            event.track, event.startNs / 1000.0, event.durationNs / 1000.0);
+        WriteJsonString(file, event.name);
+        std::fputc('}', file);
+    }
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+    return true;
+}
+
+uint64_t Profiler::CapturedEvents() {
+    return captured.size();
+}
+
+uint64_t Profiler::DroppedEvents() {
+    return dropped.load();
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+
+// Frame profiler. Scopes record (name, start, duration) into a lock-free ring owned by
+// the calling thread; one consumer thread drains the rings with Collect while a capture
+// is running and writes the result as Chrome trace JSON (chrome://tracing, Perfetto).
+//
+// Instrumentation goes through the AIM_PROFILE_* macros, which compile to nothing unless
+// AIM_PROFILE is defined. Compiled in but not capturing, a scope costs one relaxed load.
+
+struct ProfileEvent {
+    const char* name; // Must outlive the capture; string literals only
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint32_t track;   // Thread, or GPU_TRACK
+};
+
+class Profiler {
+public:
+    static const uint32_t GPU_TRACK = 0;
+
+    static void BeginCapture();
+    // Stops recording and collects what the rings still hold
+    static void EndCapture();
+    static bool IsCapturing();
+
+    // Nanoseconds on a steady clock; never 0
+    static uint64_t NowNs();
+
+    // Names the calling thread's track in the trace
+    static void SetThreadName(const char* name);
+
+    // Adds an event to the calling thread's ring; dropped if the ring is full
+    static void Record(const char* name, uint64_t startNs, uint64_t durationNs);
+    static void RecordOnTrack(uint32_t track, const char* name, uint64_t startNs, uint64_t durationNs);
+
+    // Moves events from every thread's ring into the capture. Call regularly (once a
+    // frame) and always from the same thread.
+    static void Collect();
+
+    // Writes the captured events; call from the thread that calls Collect
+    static bool WriteChromeTrace(const char* path);
+
+    static uint64_t CapturedEvents();
+    static uint64_t DroppedEvents();
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : name(name), startNs(Profiler::IsCapturing() ? Profiler::NowNs() : 0) {}
+    ~ProfileScope() {
+        if (startNs) Profiler::Record(name, startNs, Profiler::NowNs() - startNs);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+#define AIM_PROFILE_CONCAT_INNER(a, b) a##b
+#define AIM_PROFILE_CONCAT(a, b) AIM_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef AIM_PROFILE
+#define AIM_PROFILE_SCOPE(name) ProfileScope AIM_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define AIM_PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#else
+#define AIM_PROFILE_SCOPE(name) ((void)0)
+#define AIM_PROFILE_THREAD(name) ((void)0)
+#endif
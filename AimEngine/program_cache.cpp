@@ -0,0 +1,222 @@
+#include "program_cache.h"
+#include "mapped_file.h"
+#include <glad/glad.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static const char PROGRAM_CACHE_MAGIC[4] = { 'A', 'I', 'M', 'P' };
+static const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+// Program binaries are core only from GL 4.1 (before that ARB_get_program_binary), so a
+// GL 3.3 core glad has neither the entry points nor the enums. Open fetches the entry
+// points from the context's loader once the driver reports a binary format.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum name, GLint value);
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufferSize, GLsizei* length, GLenum* format, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum format, const void* binary, GLsizei length);
+
+static ProgramParameteriProc programParameteri = nullptr;
+static GetProgramBinaryProc getProgramBinary = nullptr;
+static ProgramBinaryProc programBinary = nullptr;
+
+// FNV-1a continued from hash, over the string and its terminating zero so that no two
+// different lists of strings run together into the same bytes
+static uint64_t HashString(uint64_t hash, const char* text) {
+    for (const char* c = text;; ++c) {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+        if (!*c) return hash;
+    }
+}
+
+static const char* GetString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+static unsigned int CompileShader(GLenum type, const char* source, const char* stage) {
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::" << stage << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+static unsigned int LinkProgram(const char* vertexSource, const char* fragmentSource, bool retrievable) {
+    unsigned int vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource, "VERTEX");
+    unsigned int fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource, "FRAGMENT");
+
+    unsigned int program = glCreateProgram();
+    // Some drivers only keep a binary to hand back when asked before linking
+    if (retrievable) programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+void ProgramCache::Open(const char* cachePath, void* (*getProcAddress)(const char* name)) {
+    path = cachePath;
+    entries.clear();
+    dirty = false;
+    driver = std::string(GetString(GL_VENDOR)) + '\n' + GetString(GL_RENDERER) + '\n' + GetString(GL_VERSION);
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    // Contexts without ARB_get_program_binary reject the query
+    while (glGetError() != GL_NO_ERROR) {}
+    binaries = formats > 0;
+    if (binaries) {
+        programParameteri = reinterpret_cast<ProgramParameteriProc>(getProcAddress("glProgramParameteri"));
+        getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(getProcAddress("glGetProgramBinary"));
+        programBinary = reinterpret_cast<ProgramBinaryProc>(getProcAddress("glProgramBinary"));
+        binaries = programParameteri && getProgramBinary && programBinary;
+    }
+    if (!binaries) return;
+
+    // No file yet is the first launch, not an error
+    std::FILE* in = std::fopen(cachePath, "rb");
+    if (!in) return;
+    std::vector<unsigned char> contents;
+    unsigned char buffer[1 << 16];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        contents.insert(contents.end(), buffer, buffer + read);
+    }
+    std::fclose(in);
+
+    size_t cursor = 0;
+    auto get = [&](void* out, size_t size) {
+        if (contents.size() - cursor < size) return false;
+        std::memcpy(out, contents.data() + cursor, size);
+        cursor += size;
+        return true;
+    };
+    char magic[4];
+    uint32_t version = 0, count = 0;
+    bool valid = get(magic, sizeof(magic)) && std::memcmp(magic, PROGRAM_CACHE_MAGIC, sizeof(magic)) == 0 &&
+                 get(&version, sizeof(version)) && version == PROGRAM_CACHE_VERSION && get(&count, sizeof(count));
+    for (uint32_t i = 0; valid && i < count; ++i) {
+        Entry entry = {};
+        uint32_t size = 0;
+        valid = get(&entry.key, sizeof(entry.key)) && get(&entry.format, sizeof(entry.format)) &&
+                get(&size, sizeof(size)) && contents.size() - cursor >= size;
+        if (!valid) break;
+        entry.binary.assign(contents.begin() + cursor, contents.begin() + cursor + size);
+        cursor += size;
+        entries.push_back(std::move(entry));
+    }
+    if (!valid) {
+        // Rebuilt from source and rewritten on Save
+        std::cout << "ERROR::PROGRAM_CACHE::BAD_FILE\n" << cachePath << std::endl;
+        entries.clear();
+    }
+}
+
+unsigned int ProgramCache::Link(const char* vertexSource, const char* fragmentSource) {
+    uint64_t key = HashString(HashString(HashString(14695981039346656037ull, driver.c_str()), vertexSource), fragmentSource);
+    for (size_t i = 0; binaries && i < entries.size(); ++i) {
+        if (entries[i].key != key) continue;
+        unsigned int program = LinkFromBinary(entries[i]);
+        if (program) {
+            entries[i].used = true;
+            hits++;
+            return program;
+        }
+        // A driver may refuse binaries from an older build that reports the same strings
+        entries.erase(entries.begin() + i);
+        break;
+    }
+
+    misses++;
+    unsigned int program = LinkProgram(vertexSource, fragmentSource, binaries);
+    GLint linked = 0, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (binaries && linked) glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length > 0) {
+        Entry entry = { key, 0, std::vector<unsigned char>(length), true };
+        GLenum format = 0;
+        GLsizei written = 0;
+        getProgramBinary(program, length, &written, &format, entry.binary.data());
+        if (written > 0) {
+            entry.format = format;
+            entry.binary.resize(written);
+            entries.push_back(std::move(entry));
+            dirty = true;
+        }
+    }
+    return program;
+}
+
+unsigned int ProgramCache::LinkFromBinary(const Entry& entry) {
+    unsigned int program = glCreateProgram();
+    programBinary(program, entry.format, entry.binary.data(), static_cast<GLsizei>(entry.binary.size()));
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    // An unknown format is an error rather than a failed link
+    while (glGetError() != GL_NO_ERROR) {}
+    if (!linked) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+bool ProgramCache::Save() {
+    if (!dirty) return true;
+
+    ReplacementFile file;
+    if (!file.Open(path.c_str())) {
+        std::cout << "ERROR::PROGRAM_CACHE::WRITE_FAILED\n" << path << std::endl;
+        return false;
+    }
+    std::FILE* out = file.Stream();
+    uint32_t count = 0;
+    for (const Entry& entry : entries) count += entry.used ? 1 : 0;
+    std::fwrite(PROGRAM_CACHE_MAGIC, 1, sizeof(PROGRAM_CACHE_MAGIC), out);
+    std::fwrite(&PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION), 1, out);
+    std::fwrite(&count, sizeof(count), 1, out);
+    for (const Entry& entry : entries) {
+        if (!entry.used) continue;
+        uint32_t size = static_cast<uint32_t>(entry.binary.size());
+        std::fwrite(&entry.key, sizeof(entry.key), 1, out);
+        std::fwrite(&entry.format, sizeof(entry.format), 1, out);
+        std::fwrite(&size, sizeof(size), 1, out);
+        std::fwrite(entry.binary.data(), 1, size, out);
+    }
+    if (!file.Commit()) {
+        std::cout << "ERROR::PROGRAM_CACHE::WRITE_FAILED\n" << path << std::endl;
+        return false;
+    }
+    dirty = false;
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Linked GL programs kept on disk between launches, so a warm start skips compiling and
+// linking GLSL. Entries are keyed by a hash of the driver's vendor, renderer and version
+// strings and the program's sources: after a driver update or a shader edit the key misses
+// and the program is built from source again, as is any binary the driver rejects.
+// Without a cache file, or on drivers that offer no binary formats, Link just compiles.
+class ProgramCache {
+public:
+    ProgramCache() = default;
+    ProgramCache(const ProgramCache&) = delete;
+    ProgramCache& operator=(const ProgramCache&) = delete;
+
+    // Reads the cache file if there is one; a missing or corrupt file starts an empty cache.
+    // Needs a current GL context, which Link and Save also run on. getProcAddress is the
+    // loader glad was initialized with; the program binary entry points come from it.
+    void Open(const char* path, void* (*getProcAddress)(const char* name));
+
+    // Program linked from the sources, loaded from the cache when it has them
+    unsigned int Link(const char* vertexSource, const char* fragmentSource);
+
+    // Writes the file back if Link added anything. Only the entries used since Open are
+    // kept, so binaries for old drivers and old shaders do not pile up.
+    bool Save();
+
+    int Hits() const { return hits; }
+    int Misses() const { return misses; }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t format;
+        std::vector<unsigned char> binary;
+        bool used;
+    };
+
+    std::string path;
+    std::vector<Entry> entries;
+    std::string driver; // Vendor, renderer and version, part of every key
+    bool binaries = false; // The driver has at least one program binary format
+    bool dirty = false;
+    int hits = 0;
+    int misses = 0;
+
+    unsigned int LinkFromBinary(const Entry& entry);
+};
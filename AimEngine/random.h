@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+// Seedable engine PRNG (xoshiro128**). Same seed, same sequence on every platform and
+// standard library, which std::rand does not guarantee, so sessions can be replayed.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 1) { Seed(seed); }
+
+    // Expands the seed with splitmix64 so nearby seeds give unrelated streams
+    void Seed(uint64_t seed) {
+        for (uint32_t& word : state) {
+            seed += 0x9E3779B97F4A7C15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+        }
+    }
+
+    uint32_t NextU32() {
+        uint32_t result = Rotl(state[1] * 5, 7) * 9;
+        uint32_t t = state[1] << 9;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = Rotl(state[3], 11);
+        return result;
+    }
+
+    // Uniform in [0, 1)
+    float Next01() {
+        return static_cast<float>(NextU32() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform in [0, n) for n > 0
+    int NextInt(int n) {
+        return std::min(static_cast<int>(Next01() * n), n - 1);
+    }
+
+    // Standard normal, by the Box-Muller transform
+    float NextGaussian() {
+        float u = 1.0f - Next01(); // (0, 1], so the log is finite
+        float v = Next01();
+        return std::sqrt(-2.0f * std::log(u)) * std::cos(6.2831853f * v);
+    }
+
+    // For sessions that do not need to be reproduced
+    static uint64_t ClockSeed() {
+        return static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    }
+
+private:
+    uint32_t state[4];
+
+    static uint32_t Rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+};
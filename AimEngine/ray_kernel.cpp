@@ -0,0 +1,397 @@
+#include "ray_kernel.h"
+#include <algorithm>
+#include <cfloat>
+#include "cpu_features.h"
+#include <cmath>
+
+namespace {
+
+bool scalarOnly = false;
+
+// Per-sphere test shared by every path: nearest root in front of the origin
+inline bool SphereT(const TargetSoA& soa, int i, const glm::vec3& o, const glm::vec3& d, float& t) {
+    float ocx = o.x - soa.x[i];
+    float ocy = o.y - soa.y[i];
+    float ocz = o.z - soa.z[i];
+    float b = ocx * d.x + ocy * d.y + ocz * d.z;
+    float c = ocx * ocx + ocy * ocy + ocz * ocz - soa.radius[i] * soa.radius[i];
+    float discriminant = b * b - c;
+    if (discriminant < 0.0f) return false;
+    float root = std::sqrt(discriminant);
+    float tNear = -b - root;
+    t = tNear > 0.0f ? tNear : -b + root;
+    return t > 0.0f;
+}
+
+// Distance from the ray to the sphere's surface
+inline float SphereGap(const TargetSoA& soa, int i, const glm::vec3& o, const glm::vec3& d) {
+    float vx = soa.x[i] - o.x;
+    float vy = soa.y[i] - o.y;
+    float vz = soa.z[i] - o.z;
+    float along = std::max(0.0f, vx * d.x + vy * d.y + vz * d.z);
+    float px = vx - along * d.x;
+    float py = vy - along * d.y;
+    float pz = vz - along * d.z;
+    return std::sqrt(px * px + py * py + pz * pz) - soa.radius[i];
+}
+
+// Lower bound on the distance from the sphere's center to the cone: the distance to the
+// cone's edge in the plane through the axis and the center, which is never more than the
+// true distance. Below the radius, the sphere may touch the cone.
+inline bool InCone(const TargetSoA& soa, int i, const glm::vec3& apex, const glm::vec3& axis, float cosAngle, float sinAngle) {
+    glm::vec3 v(soa.x[i] - apex.x, soa.y[i] - apex.y, soa.z[i] - apex.z);
+    float along = glm::dot(v, axis);
+    float across = std::sqrt(std::max(glm::dot(v, v) - along * along, 0.0f));
+    return across * cosAngle - along * sinAngle < soa.radius[i];
+}
+
+int ConeScalar(const TargetSoA& soa, const glm::vec3& apex, const glm::vec3& axis, float cosAngle, float sinAngle, int* candidates) {
+    int count = 0;
+    for (int i = 0; i < soa.count; ++i) {
+        if (!soa.IsHit(i) && InCone(soa, i, apex, axis, cosAngle, sinAngle)) candidates[count++] = i;
+    }
+    return count;
+}
+
+int NearestScalar(const TargetSoA& soa, const glm::vec3& o, const glm::vec3& d, float& tHit) {
+    int nearest = -1;
+    float nearestT = FLT_MAX;
+    for (int i = 0; i < soa.count; ++i) {
+        float t;
+        if (!soa.IsHit(i) && SphereT(soa, i, o, d, t) && t < nearestT) {
+            nearestT = t;
+            nearest = i;
+        }
+    }
+    if (nearest >= 0) tHit = nearestT;
+    return nearest;
+}
+
+int GapScalar(const TargetSoA& soa, const glm::vec3& o, const glm::vec3& d, float& gap) {
+    int nearest = -1;
+    float nearestGap = FLT_MAX;
+    for (int i = 0; i < soa.count; ++i) {
+        if (soa.IsHit(i)) continue;
+        float sphereGap = SphereGap(soa, i, o, d);
+        if (sphereGap < nearestGap) {
+            nearestGap = sphereGap;
+            nearest = i;
+        }
+    }
+    if (nearest >= 0) gap = nearestGap;
+    return nearest;
+}
+
+#ifdef AIM_SIMD_X86
+
+const bool hasAvx2 = CpuHasAvx2();
+
+// Lowest value across the lanes, lowest index on ties, so all paths agree
+int ReduceLanes(const float* laneT, const int* laneIndex, int lanes, float& tHit) {
+    int nearest = -1;
+    float nearestT = FLT_MAX;
+    for (int lane = 0; lane < lanes; ++lane) {
+        if (laneIndex[lane] < 0) continue;
+        if (laneT[lane] < nearestT || (laneT[lane] == nearestT && laneIndex[lane] < nearest)) {
+            nearestT = laneT[lane];
+            nearest = laneIndex[lane];
+        }
+    }
+    if (nearest >= 0) tHit = nearestT;
+    return nearest;
+}
+
+struct Avx2Ray {
+    __m256 ox, oy, oz, dx, dy, dz;
+};
+
+AIM_TARGET_AVX2 inline void NearestBlockAvx2(const TargetSoA& soa, int base, const Avx2Ray& ray, __m256& bestT, __m256i& bestIndex) {
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256 zero = _mm256_setzero_ps();
+
+    __m256 ocx = _mm256_sub_ps(ray.ox, _mm256_loadu_ps(&soa.x[base]));
+    __m256 ocy = _mm256_sub_ps(ray.oy, _mm256_loadu_ps(&soa.y[base]));
+    __m256 ocz = _mm256_sub_ps(ray.oz, _mm256_loadu_ps(&soa.z[base]));
+    __m256 r = _mm256_loadu_ps(&soa.radius[base]);
+
+    __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ray.dx), _mm256_mul_ps(ocy, ray.dy)), _mm256_mul_ps(ocz, ray.dz));
+    __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz)), _mm256_mul_ps(r, r));
+    __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), c);
+    __m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+    __m256 negB = _mm256_sub_ps(zero, b);
+    __m256 tNear = _mm256_sub_ps(negB, root);
+    __m256 tFar = _mm256_add_ps(negB, root);
+    __m256 t = _mm256_blendv_ps(tFar, tNear, _mm256_cmp_ps(tNear, zero, _CMP_GT_OQ));
+
+    __m256i hitBits = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(soa.HitBits8(base))), laneBits);
+    __m256 live = _mm256_castsi256_ps(_mm256_cmpeq_epi32(hitBits, _mm256_setzero_si256()));
+
+    __m256 valid = _mm256_and_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+    valid = _mm256_and_ps(valid, live);
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, bestT, _CMP_LT_OQ));
+
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32(base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    bestT = _mm256_blendv_ps(bestT, t, valid);
+    bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), valid));
+}
+
+AIM_TARGET_AVX2 int NearestAvx2(const TargetSoA& soa, const glm::vec3& o, const glm::vec3& d, float& tHit) {
+    Avx2Ray ray;
+    ray.ox = _mm256_set1_ps(o.x); ray.oy = _mm256_set1_ps(o.y); ray.oz = _mm256_set1_ps(o.z);
+    ray.dx = _mm256_set1_ps(d.x); ray.dy = _mm256_set1_ps(d.y); ray.dz = _mm256_set1_ps(d.z);
+
+    // Two independent accumulators: 16 spheres per iteration
+    __m256 bestT0 = _mm256_set1_ps(FLT_MAX), bestT1 = bestT0;
+    __m256i bestIndex0 = _mm256_set1_epi32(-1), bestIndex1 = bestIndex0;
+    int padded = static_cast<int>(soa.x.size());
+    for (int base = 0; base < padded; base += 16) {
+        NearestBlockAvx2(soa, base, ray, bestT0, bestIndex0);
+        NearestBlockAvx2(soa, base + 8, ray, bestT1, bestIndex1);
+    }
+
+    alignas(32) float laneT[16];
+    alignas(32) int laneIndex[16];
+    _mm256_store_ps(laneT, bestT0);
+    _mm256_store_ps(laneT + 8, bestT1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndex), bestIndex0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndex + 8), bestIndex1);
+    return ReduceLanes(laneT, laneIndex, 16, tHit);
+}
+
+AIM_TARGET_AVX2 inline void GapBlockAvx2(const TargetSoA& soa, int base, const Avx2Ray& ray, __m256& bestGap, __m256i& bestIndex) {
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256 zero = _mm256_setzero_ps();
+
+    __m256 vx = _mm256_sub_ps(_mm256_loadu_ps(&soa.x[base]), ray.ox);
+    __m256 vy = _mm256_sub_ps(_mm256_loadu_ps(&soa.y[base]), ray.oy);
+    __m256 vz = _mm256_sub_ps(_mm256_loadu_ps(&soa.z[base]), ray.oz);
+    __m256 along = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, ray.dx), _mm256_mul_ps(vy, ray.dy)), _mm256_mul_ps(vz, ray.dz));
+    along = _mm256_max_ps(along, zero);
+    __m256 px = _mm256_sub_ps(vx, _mm256_mul_ps(along, ray.dx));
+    __m256 py = _mm256_sub_ps(vy, _mm256_mul_ps(along, ray.dy));
+    __m256 pz = _mm256_sub_ps(vz, _mm256_mul_ps(along, ray.dz));
+    __m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), _mm256_mul_ps(pz, pz));
+    __m256 gap = _mm256_sub_ps(_mm256_sqrt_ps(lengthSq), _mm256_loadu_ps(&soa.radius[base]));
+
+    __m256i hitBits = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(soa.HitBits8(base))), laneBits);
+    __m256 live = _mm256_castsi256_ps(_mm256_cmpeq_epi32(hitBits, _mm256_setzero_si256()));
+    __m256 better = _mm256_and_ps(live, _mm256_cmp_ps(gap, bestGap, _CMP_LT_OQ));
+
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32(base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    bestGap = _mm256_blendv_ps(bestGap, gap, better);
+    bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), better));
+}
+
+AIM_TARGET_AVX2 int GapAvx2(const TargetSoA& soa, const glm::vec3& o, const glm::vec3& d, float& gap) {
+    Avx2Ray ray;
+    ray.ox = _mm256_set1_ps(o.x); ray.oy = _mm256_set1_ps(o.y); ray.oz = _mm256_set1_ps(o.z);
+    ray.dx = _mm256_set1_ps(d.x); ray.dy = _mm256_set1_ps(d.y); ray.dz = _mm256_set1_ps(d.z);
+
+    __m256 bestGap0 = _mm256_set1_ps(FLT_MAX), bestGap1 = bestGap0;
+    __m256i bestIndex0 = _mm256_set1_epi32(-1), bestIndex1 = bestIndex0;
+    int padded = static_cast<int>(soa.x.size());
+    for (int base = 0; base < padded; base += 16) {
+        GapBlockAvx2(soa, base, ray, bestGap0, bestIndex0);
+        GapBlockAvx2(soa, base + 8, ray, bestGap1, bestIndex1);
+    }
+
+    alignas(32) float laneGap[16];
+    alignas(32) int laneIndex[16];
+    _mm256_store_ps(laneGap, bestGap0);
+    _mm256_store_ps(laneGap + 8, bestGap1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndex), bestIndex0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndex + 8), bestIndex1);
+    return ReduceLanes(laneGap, laneIndex, 16, gap);
+}
+
+AIM_TARGET_AVX2 int ConeAvx2(const TargetSoA& soa, const glm::vec3& apex, const glm::vec3& axis, float cosAngle, float sinAngle, int* candidates) {
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 px = _mm256_set1_ps(apex.x), py = _mm256_set1_ps(apex.y), pz = _mm256_set1_ps(apex.z);
+    __m256 ax = _mm256_set1_ps(axis.x), ay = _mm256_set1_ps(axis.y), az = _mm256_set1_ps(axis.z);
+    __m256 cosA = _mm256_set1_ps(cosAngle), sinA = _mm256_set1_ps(sinAngle);
+
+    int count = 0;
+    int padded = static_cast<int>(soa.x.size());
+    for (int base = 0; base < padded; base += 8) {
+        __m256 vx = _mm256_sub_ps(_mm256_loadu_ps(&soa.x[base]), px);
+        __m256 vy = _mm256_sub_ps(_mm256_loadu_ps(&soa.y[base]), py);
+        __m256 vz = _mm256_sub_ps(_mm256_loadu_ps(&soa.z[base]), pz);
+        __m256 along = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, ax), _mm256_mul_ps(vy, ay)), _mm256_mul_ps(vz, az));
+        __m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+        __m256 across = _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(lengthSq, _mm256_mul_ps(along, along)), zero));
+        __m256 gap = _mm256_sub_ps(_mm256_mul_ps(across, cosA), _mm256_mul_ps(along, sinA));
+        unsigned inside = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(gap, _mm256_loadu_ps(&soa.radius[base]), _CMP_LT_OQ)));
+        inside &= ~soa.HitBits8(base);
+        // Almost every block is empty; the lane loop only runs for the few that are not
+        for (int lane = 0; inside; ++lane, inside >>= 1) {
+            if (inside & 1u) candidates[count++] = base + lane;
+        }
+    }
+    return count;
+}
+
+inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+int NearestSse2(const TargetSoA& soa, const glm::vec3& o, const glm::vec3& d, float& tHit) {
+    const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 ox = _mm_set1_ps(o.x), oy = _mm_set1_ps(o.y), oz = _mm_set1_ps(o.z);
+    __m128 dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y), dz = _mm_set1_ps(d.z);
+
+    __m128 bestT = _mm_set1_ps(FLT_MAX);
+    __m128 bestIndex = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    int padded = static_cast<int>(soa.x.size());
+    for (int base = 0; base < padded; base += 4) {
+        __m128 ocx = _mm_sub_ps(ox, _mm_loadu_ps(&soa.x[base]));
+        __m128 ocy = _mm_sub_ps(oy, _mm_loadu_ps(&soa.y[base]));
+        __m128 ocz = _mm_sub_ps(oz, _mm_loadu_ps(&soa.z[base]));
+        __m128 r = _mm_loadu_ps(&soa.radius[base]);
+
+        __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, dx), _mm_mul_ps(ocy, dy)), _mm_mul_ps(ocz, dz));
+        __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz)), _mm_mul_ps(r, r));
+        __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), c);
+        __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+        __m128 negB = _mm_sub_ps(zero, b);
+        __m128 tNear = _mm_sub_ps(negB, root);
+        __m128 t = Select(_mm_cmpgt_ps(tNear, zero), tNear, _mm_add_ps(negB, root));
+
+        __m128i hitBits = _mm_and_si128(_mm_set1_epi32(static_cast<int>(soa.HitBits4(base))), laneBits);
+        __m128 live = _mm_castsi128_ps(_mm_cmpeq_epi32(hitBits, _mm_setzero_si128()));
+
+        __m128 valid = _mm_and_ps(_mm_cmpge_ps(discriminant, zero), _mm_cmpgt_ps(t, zero));
+        valid = _mm_and_ps(_mm_and_ps(valid, live), _mm_cmplt_ps(t, bestT));
+
+        __m128 index = _mm_castsi128_ps(_mm_add_epi32(_mm_set1_epi32(base), _mm_setr_epi32(0, 1, 2, 3)));
+        bestT = Select(valid, t, bestT);
+        bestIndex = Select(valid, index, bestIndex);
+    }
+
+    float laneT[4];
+    int laneIndex[4];
+    _mm_storeu_ps(laneT, bestT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(laneIndex), _mm_castps_si128(bestIndex));
+    return ReduceLanes(laneT, laneIndex, 4, tHit);
+}
+
+int GapSse2(const TargetSoA& soa, const glm::vec3& o, const glm::vec3& d, float& gap) {
+    const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 ox = _mm_set1_ps(o.x), oy = _mm_set1_ps(o.y), oz = _mm_set1_ps(o.z);
+    __m128 dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y), dz = _mm_set1_ps(d.z);
+
+    __m128 bestGap = _mm_set1_ps(FLT_MAX);
+    __m128 bestIndex = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    int padded = static_cast<int>(soa.x.size());
+    for (int base = 0; base < padded; base += 4) {
+        __m128 vx = _mm_sub_ps(_mm_loadu_ps(&soa.x[base]), ox);
+        __m128 vy = _mm_sub_ps(_mm_loadu_ps(&soa.y[base]), oy);
+        __m128 vz = _mm_sub_ps(_mm_loadu_ps(&soa.z[base]), oz);
+        __m128 along = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, dx), _mm_mul_ps(vy, dy)), _mm_mul_ps(vz, dz)), zero);
+        __m128 px = _mm_sub_ps(vx, _mm_mul_ps(along, dx));
+        __m128 py = _mm_sub_ps(vy, _mm_mul_ps(along, dy));
+        __m128 pz = _mm_sub_ps(vz, _mm_mul_ps(along, dz));
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz));
+        __m128 gapLanes = _mm_sub_ps(_mm_sqrt_ps(lengthSq), _mm_loadu_ps(&soa.radius[base]));
+
+        __m128i hitBits = _mm_and_si128(_mm_set1_epi32(static_cast<int>(soa.HitBits4(base))), laneBits);
+        __m128 live = _mm_castsi128_ps(_mm_cmpeq_epi32(hitBits, _mm_setzero_si128()));
+        __m128 better = _mm_and_ps(live, _mm_cmplt_ps(gapLanes, bestGap));
+
+        __m128 index = _mm_castsi128_ps(_mm_add_epi32(_mm_set1_epi32(base), _mm_setr_epi32(0, 1, 2, 3)));
+        bestGap = Select(better, gapLanes, bestGap);
+        bestIndex = Select(better, index, bestIndex);
+    }
+
+    float laneGap[4];
+    int laneIndex[4];
+    _mm_storeu_ps(laneGap, bestGap);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(laneIndex), _mm_castps_si128(bestIndex));
+    return ReduceLanes(laneGap, laneIndex, 4, gap);
+}
+
+int ConeSse2(const TargetSoA& soa, const glm::vec3& apex, const glm::vec3& axis, float cosAngle, float sinAngle, int* candidates) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 px = _mm_set1_ps(apex.x), py = _mm_set1_ps(apex.y), pz = _mm_set1_ps(apex.z);
+    __m128 ax = _mm_set1_ps(axis.x), ay = _mm_set1_ps(axis.y), az = _mm_set1_ps(axis.z);
+    __m128 cosA = _mm_set1_ps(cosAngle), sinA = _mm_set1_ps(sinAngle);
+
+    int count = 0;
+    int padded = static_cast<int>(soa.x.size());
+    for (int base = 0; base < padded; base += 4) {
+        __m128 vx = _mm_sub_ps(_mm_loadu_ps(&soa.x[base]), px);
+        __m128 vy = _mm_sub_ps(_mm_loadu_ps(&soa.y[base]), py);
+        __m128 vz = _mm_sub_ps(_mm_loadu_ps(&soa.z[base]), pz);
+        __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, ax), _mm_mul_ps(vy, ay)), _mm_mul_ps(vz, az));
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        __m128 across = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSq, _mm_mul_ps(along, along)), zero));
+        __m128 gap = _mm_sub_ps(_mm_mul_ps(across, cosA), _mm_mul_ps(along, sinA));
+        unsigned inside = static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(gap, _mm_loadu_ps(&soa.radius[base]))));
+        inside &= ~soa.HitBits4(base);
+        for (int lane = 0; inside; ++lane, inside >>= 1) {
+            if (inside & 1u) candidates[count++] = base + lane;
+        }
+    }
+    return count;
+}
+
+#endif
+
+}
+
+int RaySphereNearest(const TargetSoA& soa, const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float& tHit) {
+#ifdef AIM_SIMD_X86
+    if (!scalarOnly) {
+        if (hasAvx2) return NearestAvx2(soa, rayOrigin, rayDirection, tHit);
+        return NearestSse2(soa, rayOrigin, rayDirection, tHit);
+    }
+#endif
+    return NearestScalar(soa, rayOrigin, rayDirection, tHit);
+}
+
+int RaySphereNearestIndexed(const TargetSoA& soa, const int* indices, int count,
+                            const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float& tHit) {
+    // Grid cells hold a handful of entries, too few to be worth a gather
+    int nearest = -1;
+    for (int k = 0; k < count; ++k) {
+        int i = indices[k];
+        float t;
+        if (!soa.IsHit(i) && SphereT(soa, i, rayOrigin, rayDirection, t) && t < tHit) {
+            tHit = t;
+            nearest = i;
+        }
+    }
+    return nearest;
+}
+
+int RaySphereNearestGap(const TargetSoA& soa, const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float& gap) {
+#ifdef AIM_SIMD_X86
+    if (!scalarOnly) {
+        if (hasAvx2) return GapAvx2(soa, rayOrigin, rayDirection, gap);
+        return GapSse2(soa, rayOrigin, rayDirection, gap);
+    }
+#endif
+    return GapScalar(soa, rayOrigin, rayDirection, gap);
+}
+
+int SphereConeCandidates(const TargetSoA& soa, const glm::vec3& apex, const glm::vec3& axis, float cosAngle, float sinAngle, int* candidates) {
+#ifdef AIM_SIMD_X86
+    if (!scalarOnly) {
+        if (hasAvx2) return ConeAvx2(soa, apex, axis, cosAngle, sinAngle, candidates);
+        return ConeSse2(soa, apex, axis, cosAngle, sinAngle, candidates);
+    }
+#endif
+    return ConeScalar(soa, apex, axis, cosAngle, sinAngle, candidates);
+}
+
+const char* RayKernelName() {
+#ifdef AIM_SIMD_X86
+    if (!scalarOnly) return hasAvx2 ? "avx2" : "sse2";
+#endif
+    return "scalar";
+}
+
+void SetRayKernelScalarOnly(bool enabled) {
+    scalarOnly = enabled;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "target_soa.h"
+#include <glm/glm.hpp>
+
+// Nearest live sphere hit by the ray at t > 0, or -1 on a miss. rayDirection must be
+// normalized. Uses AVX2 (16 lanes per iteration) or SSE2 (4 lanes) when the CPU has
+// them and a scalar loop otherwise. Ties go to the lowest index on every path.
+int RaySphereNearest(const TargetSoA& soa, const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float& tHit);
+
+// Same test restricted to a list of indices (e.g. one grid cell). Only hits closer
+// than tHit are reported; tHit is updated when one is found.
+int RaySphereNearestIndexed(const TargetSoA& soa, const int* indices, int count,
+                            const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float& tHit);
+
+// Live sphere whose surface the ray passes closest to, measured from the point at t >= 0
+// nearest its center, and that gap (negative when the ray goes through it); -1 when every
+// sphere is hit. rayDirection must be normalized. Ties go to the lowest index on every path.
+int RaySphereNearestGap(const TargetSoA& soa, const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float& gap);
+
+// Writes the indices of live spheres that may touch the cone with the given apex, unit
+// axis and half-angle (as its cosine and sine) to candidates, in index order, and returns
+// how many there are. Conservative: a sphere left out is certain to miss every ray inside
+// the cone. candidates needs room for soa.count indices.
+int SphereConeCandidates(const TargetSoA& soa, const glm::vec3& apex, const glm::vec3& axis, float cosAngle, float sinAngle, int* candidates);
+
+// Name of the kernel RaySphereNearest dispatches to ("avx2", "sse2" or "scalar")
+const char* RayKernelName();
+
+// Forces the scalar fallback, for benchmarking and for checking the SIMD paths
+void SetRayKernelScalarOnly(bool enabled);
@@ -0,0 +1,272 @@
+#include "recording.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+static const char RECORDING_MAGIC[4] = { 'A', 'I', 'M', 'R' };
+// Version 2 added target motion to the scenario, version 3 swept hits, version 4 arena
+// walls that stop shots and version 5 the mouse position in window pixels. Older files
+// still replay, with shots going through the walls as they did when they were recorded.
+static const uint32_t RECORDING_VERSION = 5;
+
+static uint64_t ZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Scenario fields in file order; reader and writer share the list so they cannot drift
+template <typename Visit>
+static void VisitConfig(SimConfig& config, uint32_t version, Visit visit) {
+    visit(&config.seed, sizeof(config.seed));
+    visit(&config.tickRate, sizeof(config.tickRate));
+    visit(&config.targetMinX, sizeof(float));
+    visit(&config.targetMaxX, sizeof(float));
+    visit(&config.targetMinY, sizeof(float));
+    visit(&config.targetMaxY, sizeof(float));
+    visit(&config.targetZ, sizeof(float));
+    visit(&config.targetRadius, sizeof(float));
+    visit(&config.targetCount, sizeof(config.targetCount));
+    visit(&config.cameraStart, sizeof(config.cameraStart));
+    visit(&config.screenWidth, sizeof(float));
+    visit(&config.screenHeight, sizeof(float));
+    visit(&config.fovDegrees, sizeof(float));
+    visit(&config.nearPlane, sizeof(float));
+    visit(&config.farPlane, sizeof(float));
+    if (version < 2) return;
+    visit(&config.targetMotion, sizeof(config.targetMotion));
+    visit(&config.targetSpeed, sizeof(float));
+    visit(&config.targetPathSize, sizeof(float));
+    if (version < 3) return;
+    visit(&config.sweepSeconds, sizeof(float));
+}
+
+bool InputRecorder::Open(const char* path, const SimConfig& config) {
+    Close(0);
+    file = std::fopen(path, "wb");
+    if (!file) {
+        std::cout << "ERROR::RECORDING::OPEN_FAILED\n" << path << std::endl;
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 16);
+    lastTick = 0;
+    lastTimeMicros = 0;
+
+    PutBytes(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    PutBytes(&RECORDING_VERSION, sizeof(RECORDING_VERSION));
+    SimConfig header = config;
+    VisitConfig(header, RECORDING_VERSION, [this](const void* data, size_t size) { PutBytes(data, size); });
+    return true;
+}
+
+void InputRecorder::Write(uint64_t tick, const InputEvent& event) {
+    if (!file) return;
+    switch (event.type) {
+    case InputEvent::MOUSE_MOVE: BeginRecord(RecordType::MOUSE_MOVE, tick); break;
+    case InputEvent::KEY: BeginRecord(event.pressed ? RecordType::KEY_DOWN : RecordType::KEY_UP, tick); break;
+    case InputEvent::CLICK: BeginRecord(RecordType::CLICK, tick); break;
+    }
+
+    int64_t timeMicros = std::llround(event.time * 1e6);
+    PutVarint(ZigZag(timeMicros - lastTimeMicros));
+    lastTimeMicros = timeMicros;
+
+    if (event.type == InputEvent::MOUSE_MOVE) {
+        PutBytes(&event.x, sizeof(float));
+        PutBytes(&event.y, sizeof(float));
+        PutBytes(&event.rawX, sizeof(float));
+        PutBytes(&event.rawY, sizeof(float));
+    }
+    else if (event.type == InputEvent::KEY) {
+        PutVarint(ZigZag(event.key));
+    }
+}
+
+void InputRecorder::WriteResync(uint64_t tick, int64_t clockOffsetMicros) {
+    if (!file) return;
+    BeginRecord(RecordType::RESYNC, tick);
+    PutVarint(ZigZag(clockOffsetMicros));
+}
+
+void InputRecorder::Close(uint64_t finalTick) {
+    if (!file) return;
+    BeginRecord(RecordType::END, std::max(finalTick, lastTick));
+    std::fclose(file);
+    file = nullptr;
+}
+
+void InputRecorder::BeginRecord(RecordType type, uint64_t tick) {
+    uint8_t typeByte = static_cast<uint8_t>(type);
+    PutBytes(&typeByte, 1);
+    PutVarint(tick - lastTick);
+    lastTick = tick;
+}
+
+void InputRecorder::PutVarint(uint64_t value) {
+    unsigned char bytes[10];
+    int count = 0;
+    while (value >= 0x80) {
+        bytes[count++] = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = static_cast<unsigned char>(value);
+    PutBytes(bytes, count);
+}
+
+void InputRecorder::PutBytes(const void* data, size_t size) {
+    std::fwrite(data, 1, size, file);
+}
+
+bool InputRecording::Open(const char* path) {
+    if (!file.Open(path)) return false;
+
+    cursor = 0;
+    char magic[4];
+    uint32_t version = 0;
+    if (!GetBytes(magic, sizeof(magic)) || std::memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0 ||
+        !GetBytes(&version, sizeof(version)) || version < 1 || version > RECORDING_VERSION) {
+        std::cout << "ERROR::RECORDING::BAD_HEADER\n" << path << std::endl;
+        file.Close();
+        return false;
+    }
+
+    this->version = version;
+    config = SimConfig();
+    config.arenaOcclusion = version >= 4;
+    bool complete = true;
+    VisitConfig(config, version, [&](void* data, size_t size) { complete = complete && GetBytes(data, size); });
+    if (!complete || config.targetMotion > MotionPattern::SPLINE) {
+        std::cout << "ERROR::RECORDING::BAD_HEADER\n" << path << std::endl;
+        file.Close();
+        return false;
+    }
+
+    bodyOffset = cursor;
+    Rewind();
+    return true;
+}
+
+void InputRecording::Rewind() {
+    cursor = bodyOffset;
+    lastTick = 0;
+    lastTimeMicros = 0;
+}
+
+bool InputRecording::Next(InputRecord& record) {
+    if (!ReadRecord(record)) {
+        // A truncated file (e.g. the game crashed) ends after the last complete record
+        record.type = RecordType::END;
+        record.tick = lastTick;
+        return false;
+    }
+    return record.type != RecordType::END;
+}
+
+bool InputRecording::ReadRecord(InputRecord& record) {
+    uint8_t typeByte;
+    uint64_t tickDelta;
+    if (!GetBytes(&typeByte, 1) || typeByte > static_cast<uint8_t>(RecordType::END) || !GetVarint(tickDelta)) return false;
+    record.type = static_cast<RecordType>(typeByte);
+    record.tick = lastTick + tickDelta;
+    lastTick = record.tick;
+    record.event = InputEvent();
+    record.clockOffsetMicros = 0;
+
+    uint64_t value;
+    switch (record.type) {
+    case RecordType::END:
+        return true;
+
+    case RecordType::RESYNC:
+        if (!GetVarint(value)) return false;
+        record.clockOffsetMicros = UnZigZag(value);
+        return true;
+
+    default:
+        break;
+    }
+
+    if (!GetVarint(value)) return false;
+    lastTimeMicros += UnZigZag(value);
+    record.event.time = lastTimeMicros * 1e-6;
+
+    switch (record.type) {
+    case RecordType::MOUSE_MOVE:
+        record.event.type = InputEvent::MOUSE_MOVE;
+        if (!GetBytes(&record.event.x, sizeof(float)) || !GetBytes(&record.event.y, sizeof(float))) return false;
+        // Before version 5 the camera turned by the screen position's movement
+        if (version < 5) {
+            record.event.rawX = record.event.x;
+            record.event.rawY = record.event.y;
+            return true;
+        }
+        return GetBytes(&record.event.rawX, sizeof(float)) && GetBytes(&record.event.rawY, sizeof(float));
+
+    case RecordType::KEY_DOWN:
+    case RecordType::KEY_UP:
+        record.event.type = InputEvent::KEY;
+        record.event.pressed = record.type == RecordType::KEY_DOWN;
+        if (!GetVarint(value)) return false;
+        record.event.key = static_cast<int>(UnZigZag(value));
+        return true;
+
+    default:
+        record.event.type = InputEvent::CLICK;
+        return true;
+    }
+}
+
+bool InputRecording::GetVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < file.Size(); shift += 7) {
+        unsigned char byte = file.Data()[cursor++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool InputRecording::GetBytes(void* data, size_t size) {
+    if (file.Size() - cursor < size) return false;
+    std::memcpy(data, file.Data() + cursor, size);
+    cursor += size;
+    return true;
+}
+
+ReplayResult Replay(InputRecording& recording, JobSystem* jobs, ShotLog* shotLog) {
+    recording.Rewind();
+    Simulation simulation(recording.Config());
+    simulation.SetJobSystem(jobs);
+    simulation.SetShotLog(shotLog);
+
+    // After the last input record, Next leaves the END record with the final tick in record
+    InputRecord record;
+    bool more = recording.Next(record);
+    std::vector<InputEvent> events;
+    while (true) {
+        uint64_t tick = simulation.CurrentTick() + 1;
+        events.clear();
+        while (more && record.tick <= tick) {
+            if (record.type == RecordType::RESYNC) simulation.Resync(record.clockOffsetMicros);
+            else events.push_back(record.event);
+            more = recording.Next(record);
+        }
+        if (!more && tick > record.tick) break;
+        simulation.Step(events);
+    }
+
+    ReplayResult result;
+    const SimSnapshot& snapshot = simulation.LatestSnapshot();
+    result.ticks = simulation.CurrentTick();
+    result.shots = snapshot.shots;
+    result.hits = snapshot.hits;
+    result.sweptHits = snapshot.sweptHits;
+    result.stateHash = simulation.StateHash();
+    result.shotStats = snapshot.shotStats;
+    result.allocatingTicks = snapshot.allocatingTicks;
+    result.lastAllocatingTick = snapshot.lastAllocatingTick;
+    return result;
+}
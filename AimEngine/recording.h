@@ -0,0 +1,79 @@
+#pragma once
+#include "simulation.h"
+#include "mapped_file.h"
+#include <cstdio>
+#include <cstdint>
+
+// Binary session recording: a header with the seed and scenario, then one record per
+// input event. Records are a type byte, the tick delta since the previous record and the
+// event time delta in microseconds (both varints), then the payload; a mouse move is
+// about 20 bytes. Integers are little-endian.
+enum class RecordType : uint8_t { MOUSE_MOVE, KEY_DOWN, KEY_UP, CLICK, RESYNC, END };
+
+struct InputRecord {
+    RecordType type;
+    uint64_t tick;             // Tick that consumed the event
+    InputEvent event;          // Input records
+    int64_t clockOffsetMicros; // RESYNC
+};
+
+// Written from the simulation thread; buffered, so a tick only costs a few memcpys
+class InputRecorder {
+public:
+    ~InputRecorder() { Close(0); }
+
+    bool Open(const char* path, const SimConfig& config);
+    void Write(uint64_t tick, const InputEvent& event);
+    void WriteResync(uint64_t tick, int64_t clockOffsetMicros);
+    // Ends the recording after the given tick; the replay runs up to and including it
+    void Close(uint64_t finalTick);
+
+private:
+    std::FILE* file = nullptr;
+    uint64_t lastTick = 0;
+    int64_t lastTimeMicros = 0;
+
+    void BeginRecord(RecordType type, uint64_t tick);
+    void PutVarint(uint64_t value);
+    void PutBytes(const void* data, size_t size);
+};
+
+// Reads a recording through a memory mapping
+class InputRecording {
+public:
+    bool Open(const char* path);
+    const SimConfig& Config() const { return config; }
+
+    // Records in file order; false at the END record (left in record with the final tick)
+    // or where a truncated file stops
+    bool Next(InputRecord& record);
+    void Rewind();
+
+private:
+    MappedFile file;
+    SimConfig config;
+    uint32_t version = 0;
+    size_t bodyOffset = 0;
+    size_t cursor = 0;
+    uint64_t lastTick = 0;
+    int64_t lastTimeMicros = 0;
+
+    bool ReadRecord(InputRecord& record);
+    bool GetVarint(uint64_t& value);
+    bool GetBytes(void* data, size_t size);
+};
+
+struct ReplayResult {
+    uint64_t ticks = 0;
+    int shots = 0;
+    int hits = 0;
+    int sweptHits = 0;
+    uint64_t stateHash = 0;
+    ShotStats::Summary shotStats;
+    uint64_t allocatingTicks = 0; // Ticks that allocated on the heap, and the last of them
+    uint64_t lastAllocatingTick = 0;
+};
+
+// Re-simulates a recording on the calling thread with no window or renderer. jobs only
+// changes how fast it runs, never the result. Shots go to shotLog when given one.
+ReplayResult Replay(InputRecording& recording, JobSystem* jobs = nullptr, ShotLog* shotLog = nullptr);
@@ -0,0 +1,55 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// One recorded draw. The key sorts draws that share a program, mesh and material next
+// to each other; the low bits keep submission order among otherwise equal draws.
+struct DrawCommand {
+    uint64_t key;
+    glm::mat4 model;
+    glm::vec3 color;
+    int instanceOffset; // First instance in the frame's instance data (instanced draws only)
+    int instanceCount;
+};
+
+class RenderQueue {
+public:
+    // [program:4][mesh:8][material:24][sequence:28]
+    static uint64_t MakeKey(int program, int mesh, const glm::vec3& color, uint32_t sequence) {
+        return (static_cast<uint64_t>(program & 0xF) << 60) |
+               (static_cast<uint64_t>(mesh & 0xFF) << 52) |
+               (static_cast<uint64_t>(PackColor(color)) << 28) |
+               (sequence & 0xFFFFFFFu);
+    }
+
+    static int KeyProgram(uint64_t key) { return static_cast<int>(key >> 60); }
+    static int KeyMesh(uint64_t key) { return static_cast<int>((key >> 52) & 0xFF); }
+
+    void Push(int program, int mesh, const glm::mat4& model, const glm::vec3& color, int instanceOffset = 0, int instanceCount = 0) {
+        DrawCommand command;
+        command.key = MakeKey(program, mesh, color, static_cast<uint32_t>(commands.size()));
+        command.model = model;
+        command.color = color;
+        command.instanceOffset = instanceOffset;
+        command.instanceCount = instanceCount;
+        commands.push_back(command);
+    }
+
+    void Sort() {
+        std::sort(commands.begin(), commands.end(), [](const DrawCommand& a, const DrawCommand& b) { return a.key < b.key; });
+    }
+
+    void Clear() { commands.clear(); }
+    const std::vector<DrawCommand>& Commands() const { return commands; }
+
+private:
+    std::vector<DrawCommand> commands;
+
+    // 8 bits per channel is plenty to group draws that use the same color
+    static uint32_t PackColor(const glm::vec3& color) {
+        auto channel = [](float c) { return static_cast<uint32_t>(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f); };
+        return (channel(color.r) << 16) | (channel(color.g) << 8) | channel(color.b);
+    }
+};
@@ -1,21 +1,36 @@
 #include "renderer.h"
+#include "sphere_mesh.h"
+#include "program_cache.h"
+#include "mesh_loader.h"
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <algorithm>
+
+// Binding point of the per-frame camera uniform block shared by every program
+const unsigned int CAMERA_BLOCK_BINDING = 0;
 
 // [Vertex shader]
 const char* vertexShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 uMVP;
+layout (std140) uniform CameraBlock
+{
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+};
+
+uniform mat4 uModel;
 
 void main()
 {
-    gl_Position = uMVP * vec4(aPos, 1.0);
+    gl_Position = uViewProjection * uModel * vec4(aPos, 1.0);
 }
 )";
 
@@ -31,121 +46,170 @@ void main()
 }
 )";
 
-//function to generate sphere vertices
-void GenerateSphereVertices(std::vector<float>& vertices, float radius, int sectors, int stacks) {
-    const float PI = 3.1415926f;
-    std::vector<float> tmpVertices;
-
-    float sectorStep = 2 * PI / sectors;
-    float stackStep = PI / stacks;
+// [Instanced vertex shader] - one sphere per instance, scaled and offset on the GPU
+const char* instancedVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aPositionRadius;
+layout (location = 2) in vec3 aColor;
 
-    for (int i = 0; i <= stacks; ++i) {
-        float stackAngle = PI / 2 - i * stackStep;
-        float xy = radius * cosf(stackAngle);
-        float z = radius * sinf(stackAngle);
+layout (std140) uniform CameraBlock
+{
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+};
 
-        for (int j = 0; j <= sectors; ++j) {
-            float sectorAngle = j * sectorStep;
-            float x = xy * cosf(sectorAngle);
-            float y = xy * sinf(sectorAngle);
+uniform mat4 uModel; // Fits the mesh into the unit sphere; identity for the sphere LODs
 
-            tmpVertices.push_back(x);
-            tmpVertices.push_back(y);
-            tmpVertices.push_back(z);
-        }
-    }
+out vec3 vColor;
 
-    // Generate sphere triangle vertices
-    for (int i = 0; i < stacks; ++i) {
-        int k1 = i * (sectors + 1);
-        int k2 = k1 + sectors + 1;
+void main()
+{
+    vec3 worldPos = (uModel * vec4(aPos, 1.0)).xyz * aPositionRadius.w + aPositionRadius.xyz;
+    gl_Position = uViewProjection * vec4(worldPos, 1.0);
+    vColor = aColor;
+}
+)";
 
-        for (int j = 0; j < sectors; ++j, ++k1, ++k2) {
-            // Two triangles per sector
-            if (i != 0) {
-                // Triangle 1
-                vertices.push_back(tmpVertices[k1 * 3]);
-                vertices.push_back(tmpVertices[k1 * 3 + 1]);
-                vertices.push_back(tmpVertices[k1 * 3 + 2]);
+// [Instanced fragment shader]
+const char* instancedFragmentShaderSource = R"(
+#version 330 core
+in vec3 vColor;
+out vec4 FragColor;
 
-                vertices.push_back(tmpVertices[k2 * 3]);
-                vertices.push_back(tmpVertices[k2 * 3 + 1]);
-                vertices.push_back(tmpVertices[k2 * 3 + 2]);
+void main()
+{
+    FragColor = vec4(vColor, 1.0);
+}
+)";
 
-                vertices.push_back(tmpVertices[(k1 + 1) * 3]);
-                vertices.push_back(tmpVertices[(k1 + 1) * 3 + 1]);
-                vertices.push_back(tmpVertices[(k1 + 1) * 3 + 2]);
-            }
+// [Upscale vertex shader] - one triangle covering the screen, no vertex buffer
+const char* upscaleVertexShaderSource = R"(
+#version 330 core
+out vec2 vScreen;
 
-            if (i != (stacks - 1)) {
-                // Triangle 2
-                vertices.push_back(tmpVertices[(k1 + 1) * 3]);
-                vertices.push_back(tmpVertices[(k1 + 1) * 3 + 1]);
-                vertices.push_back(tmpVertices[(k1 + 1) * 3 + 2]);
+void main()
+{
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    vScreen = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
 
-                vertices.push_back(tmpVertices[k2 * 3]);
-                vertices.push_back(tmpVertices[k2 * 3 + 1]);
-                vertices.push_back(tmpVertices[k2 * 3 + 2]);
+// [Upscale fragment shader] - bilinear sample of the scene's corner of the offscreen target,
+// kept half a texel inside it so nothing past its edge bleeds in
+const char* upscaleFragmentShaderSource = R"(
+#version 330 core
+in vec2 vScreen;
+out vec4 FragColor;
+uniform sampler2D uScene;
+uniform vec2 uSceneSize;  // Scene resolution as a fraction of the target
+uniform vec2 uTexelClamp; // Largest coordinate that stays half a texel inside the scene
 
-                vertices.push_back(tmpVertices[(k2 + 1) * 3]);
-                vertices.push_back(tmpVertices[(k2 + 1) * 3 + 1]);
-                vertices.push_back(tmpVertices[(k2 + 1) * 3 + 2]);
-            }
-        }
-    }
+void main()
+{
+    vec2 uv = min(vScreen * uSceneSize, uTexelClamp);
+    FragColor = texture(uScene, uv);
 }
+)";
 
-void Renderer::Init() {
-    // Compile shaders
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
+// Per-instance position, radius and color from the instance buffer, for the bound VAO
+static void SetInstanceAttributes(unsigned int instanceVBO) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)offsetof(SphereInstance, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)offsetof(SphereInstance, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+}
 
-    // Check for vertex shader compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+void Renderer::BuildSphereMeshes(SphereLodMeshes& out) {
+    out.vertices.clear();
+    out.indices.clear();
+    for (int lod = 0; lod < SPHERE_LOD_COUNT; ++lod) {
+        out.firstIndex[lod] = static_cast<int>(out.indices.size());
+        GenerateIcosphere(SPHERE_LOD_SUBDIVISIONS[lod], out.vertices, out.indices);
+        out.indexCount[lod] = static_cast<int>(out.indices.size()) - out.firstIndex[lod];
     }
+}
 
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL); // Fixed: was using vertexShaderSource here
-    glCompileShader(fragmentShader);
-
-    // Check for fragment shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+void Renderer::Init(ProgramCache* programCache, const SphereLodMeshes* sphereMeshes) {
+#ifdef AIM_PROFILE
+    gpuProfiler.Init();
+#endif
+
+    // Compile shaders, or load them from the cache, and resolve uniform locations once
+    ProgramCache uncached;
+    ProgramCache& cache = programCache ? *programCache : uncached;
+    const char* sources[PROGRAM_COUNT][2] = {
+        { vertexShaderSource, fragmentShaderSource },
+        { instancedVertexShaderSource, instancedFragmentShaderSource },
+    };
+    for (int i = 0; i < PROGRAM_COUNT; ++i) {
+        ProgramInfo& program = programs[i];
+        program.id = cache.Link(sources[i][0], sources[i][1]);
+        program.modelLocation = glGetUniformLocation(program.id, "uModel");
+        program.colorLocation = glGetUniformLocation(program.id, "uColor");
+        glUniformBlockBinding(program.id, glGetUniformBlockIndex(program.id, "CameraBlock"), CAMERA_BLOCK_BINDING);
     }
+    upscaleProgram = cache.Link(upscaleVertexShaderSource, upscaleFragmentShaderSource);
+    upscaleSizeLocation = glGetUniformLocation(upscaleProgram, "uSceneSize");
+    upscaleClampLocation = glGetUniformLocation(upscaleProgram, "uTexelClamp");
+    glUseProgram(upscaleProgram);
+    glUniform1i(glGetUniformLocation(upscaleProgram, "uScene"), 0);
+    glUseProgram(0);
+    // Core profile needs a vertex array bound to draw, even one with no attributes
+    glGenVertexArrays(1, &upscaleVAO);
+
+    // Camera uniform buffer: view, projection, view * projection
+    glGenBuffers(1, &cameraUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+    glBufferData(GL_UNIFORM_BUFFER, 3 * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, cameraUBO);
+
+    // Sphere LODs: every level in one vertex and one index buffer, generated once
+    SphereLodMeshes built;
+    if (!sphereMeshes) {
+        BuildSphereMeshes(built);
+        sphereMeshes = &built;
+    }
+    const std::vector<float>& sphereVertices = sphereMeshes->vertices;
+    const std::vector<unsigned int>& sphereIndices = sphereMeshes->indices;
+    const int* lodFirstIndex = sphereMeshes->firstIndex;
+    const int* lodIndexCount = sphereMeshes->indexCount;
 
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    // Setup sphere VAO
-    std::vector<float> sphereVertices;
-    GenerateSphereVertices(sphereVertices, 1.0f, 36, 18);
-    sphereVerticesCount = static_cast<int>(sphereVertices.size()) / 3;
-
+    unsigned int sphereVAO;
     glGenVertexArrays(1, &sphereVAO);
     glGenBuffers(1, &sphereVBO);
+    glGenBuffers(1, &sphereEBO);
 
     glBindVertexArray(sphereVAO);
     glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-    glBufferData(GL_ARRAY_BUFFER, sphereVertices.size() * sizeof(float), &sphereVertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sphereVertices.size() * sizeof(float), sphereVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphereIndices.size() * sizeof(unsigned int), sphereIndices.data(), GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
+    // Setup instanced sphere VAO: shared sphere mesh plus one SphereInstance per instance
+    unsigned int instancedSphereVAO;
+    glGenVertexArrays(1, &instancedSphereVAO);
+    glGenBuffers(1, &instanceVBO);
+
+    glBindVertexArray(instancedSphereVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    SetInstanceAttributes(instanceVBO);
+
+    for (int lod = 0; lod < SPHERE_LOD_COUNT; ++lod) {
+        meshes[MESH_SPHERE + lod] = { sphereVAO, lodIndexCount[lod], true, lodFirstIndex[lod] };
+        meshes[MESH_INSTANCED_SPHERE + lod] = { instancedSphereVAO, lodIndexCount[lod], true, lodFirstIndex[lod] };
+    }
 
     // Setup cube VAO
     float cubeVertices[] = {
@@ -170,8 +234,7 @@ void Renderer::Init() {
         3, 2, 7, 2, 6, 7   // Top
     };
 
-    cubeVerticesCount = 36; // 12 triangles * 3 vertices
-
+    unsigned int cubeVAO;
     glGenVertexArrays(1, &cubeVAO);
     glGenBuffers(1, &cubeVBO);
     glGenBuffers(1, &cubeEBO);
@@ -186,34 +249,306 @@ void Renderer::Init() {
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+    meshes[MESH_CUBE] = { cubeVAO, 36, true, 0 }; // 12 triangles * 3 vertices
+
+    glBindVertexArray(0);
+
+    glGenQueries(FRAMES_IN_FLIGHT * 2, &frameQueries[0][0]);
+
+    // Until SetViewport is called, assume the viewport the context started with, and
+    // present into whatever framebuffer is bound now
+    int viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    viewportWidth = viewport[2];
+    viewportHeight = viewport[3];
+    int framebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    outputFramebuffer = framebuffer;
+}
+
+int Renderer::AddMesh(const MeshAsset& mesh) {
+    if (customMeshes == MAX_CUSTOM_MESHES) {
+        std::cout << "ERROR::RENDERER::TOO_MANY_MESHES\n";
+        return -1;
+    }
+    // A baked mesh is uploaded straight from its file mapping
+    unsigned int vbo, ebo, vao, instancedVao;
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glGenVertexArrays(1, &vao);
+    glGenVertexArrays(1, &instancedVao);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, mesh.VertexCount() * 3 * sizeof(float), mesh.Vertices(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.IndexCount() * sizeof(unsigned int), mesh.Indices(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // The same buffers with the instance attributes, for drawing targets with it
+    glBindVertexArray(instancedVao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    SetInstanceAttributes(instanceVBO);
+    glBindVertexArray(0);
+
+    int handle = customMeshes++;
+    meshes[MESH_CUSTOM + 2 * handle] = { vao, mesh.IndexCount(), true, 0 };
+    meshes[MESH_CUSTOM + 2 * handle + 1] = { instancedVao, mesh.IndexCount(), true, 0 };
+
+    // As a target the model stands in for the unit sphere: centered on its bounds and
+    // scaled so its farthest vertex touches the sphere, whatever units it was made in
+    glm::vec3 center = 0.5f * (mesh.Min() + mesh.Max());
+    float farthestSq = 0.0f;
+    for (int i = 0; i < mesh.VertexCount(); ++i) {
+        glm::vec3 offset = glm::vec3(mesh.Vertices()[3 * i], mesh.Vertices()[3 * i + 1], mesh.Vertices()[3 * i + 2]) - center;
+        farthestSq = std::max(farthestSq, glm::dot(offset, offset));
+    }
+    float scale = farthestSq > 0.0f ? 1.0f / std::sqrt(farthestSq) : 1.0f;
+    targetFits[handle] = glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(scale)), -center);
+    return handle;
+}
+
+void Renderer::SetViewport(int width, int height) {
+    viewportWidth = width;
+    viewportHeight = height;
+}
+
+void Renderer::SetRenderScale(float scale) {
+    renderScale = glm::clamp(scale, MIN_RENDER_SCALE, 1.0f);
+}
+
+void Renderer::ResizeSceneTarget(int width, int height) {
+    if (!sceneFBO) {
+        glGenFramebuffers(1, &sceneFBO);
+        glGenTextures(1, &sceneColor);
+        glGenRenderbuffers(1, &sceneDepth);
+    }
+    // A texture rather than a renderbuffer so the upscale can filter it
+    glBindTexture(GL_TEXTURE_2D, sceneColor);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, sceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColor, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, sceneDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR::RENDERER::SCENE_TARGET_INCOMPLETE\n";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    sceneWidth = width;
+    sceneHeight = height;
 }
 
 void Renderer::BeginFrame() {
+#ifdef AIM_PROFILE
+    gpuProfiler.BeginFrame();
+#endif
+    AIM_PROFILE_SCOPE("Renderer::BeginFrame");
+    AIM_PROFILE_GPU_SCOPE(gpuProfiler, "Clear");
+    stats = RenderStats();
+    queue.Clear();
+    frameInstances.clear();
+    frameArena.Reset();
+
+    // The oldest frame's timestamps are almost always ready by now; if not, try next time
+    // around rather than wait
+    frameQuerySlot = (frameQuerySlot + 1) % FRAMES_IN_FLIGHT;
+    if (frameQueryIssued[frameQuerySlot]) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(frameQueries[frameQuerySlot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(frameQueries[frameQuerySlot][0], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(frameQueries[frameQuerySlot][1], GL_QUERY_RESULT, &end);
+            gpuFrameMs = (end - start) * 1e-6;
+            gpuFrameScale = frameQueryScale[frameQuerySlot];
+        }
+    }
+    glQueryCounter(frameQueries[frameQuerySlot][0], GL_TIMESTAMP);
+    frameQueryScale[frameQuerySlot] = renderScale;
+    frameQueryIssued[frameQuerySlot] = true;
+
+    // At full scale the scene goes straight to the output, with nothing to copy
+    renderWidth = std::max(1, static_cast<int>(viewportWidth * renderScale + 0.5f));
+    renderHeight = std::max(1, static_cast<int>(viewportHeight * renderScale + 0.5f));
+    if (renderWidth < viewportWidth || renderHeight < viewportHeight) {
+        if (sceneWidth != viewportWidth || sceneHeight != viewportHeight) ResizeSceneTarget(viewportWidth, viewportHeight);
+        glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+    }
+    else {
+        renderWidth = viewportWidth;
+        renderHeight = viewportHeight;
+    }
+    glViewport(0, 0, renderWidth, renderHeight);
+    stats.renderWidth = renderWidth;
+    stats.renderHeight = renderHeight;
     glEnable(GL_DEPTH_TEST);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
-void Renderer::DrawCube(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& color) {
-    glUseProgram(shaderProgram);
-    glm::mat4 mvp = projection * view * model;
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "uMVP"), 1, GL_FALSE, glm::value_ptr(mvp));
-    glUniform3f(glGetUniformLocation(shaderProgram, "uColor"), color.r, color.g, color.b); // Use passed color
-    glBindVertexArray(cubeVAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+void Renderer::SetCamera(const glm::mat4& view, const glm::mat4& projection) {
+    this->view = view;
+    this->projection = projection;
+    // LODs follow the pixels actually drawn, so a lower render scale also draws coarser spheres
+    batcher.SetView(view, projection, renderHeight);
 }
 
-void Renderer::DrawSphere(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection) {
-    glUseProgram(shaderProgram);
-    glm::mat4 mvp = projection * view * model;
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "uMVP"), 1, GL_FALSE, glm::value_ptr(mvp));
-    glUniform3f(glGetUniformLocation(shaderProgram, "uColor"), 1.0f, 0.3f, 0.3f);
-    glBindVertexArray(sphereVAO);
-    glDrawArrays(GL_TRIANGLES, 0, sphereVerticesCount);
-    glBindVertexArray(0);
+void Renderer::DrawCube(const glm::mat4& model, const glm::vec3& color) {
+    queue.Push(PROGRAM_BASIC, MESH_CUBE, model, color);
+}
+
+void Renderer::DrawMesh(int mesh, const glm::mat4& model, const glm::vec3& color) {
+    if (mesh >= 0 && mesh < customMeshes) queue.Push(PROGRAM_BASIC, MESH_CUSTOM + 2 * mesh, model, color);
+}
+
+void Renderer::DrawSphere(const glm::mat4& model, const glm::vec3& color) {
+    // Unit sphere, so the model's largest axis scale is the radius
+    float radius = std::sqrt(std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+                             std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2])))));
+    if (!batcher.GetFrustum().IntersectsSphere(glm::vec3(model[3]), radius)) {
+        stats.culled++;
+        return;
+    }
+    stats.visible++;
+    int lod = batcher.SelectLod(glm::vec3(model[3]), radius);
+    if (targetMesh >= 0) queue.Push(PROGRAM_BASIC, MESH_CUSTOM + 2 * targetMesh, model * targetFits[targetMesh], color);
+    else queue.Push(PROGRAM_BASIC, MESH_SPHERE + lod, model, color);
+}
+
+void Renderer::DrawSpheresInstanced(const SphereInstance* instances, int count) {
+    SphereBatcher::Batches batches;
+    {
+        AIM_PROFILE_SCOPE("Batch spheres");
+        batches = batcher.Append(instances, count, frameInstances, frameArena, jobs);
+    }
+    stats.visible += batches.visible;
+    stats.culled += batches.culled;
+
+    // Each LOD is one contiguous run of instances and one draw; a target model has no LODs,
+    // so every run draws it whole
+    for (int lod = 0; lod < SPHERE_LOD_COUNT; ++lod) {
+        int mesh = targetMesh >= 0 ? MESH_CUSTOM + 2 * targetMesh + 1 : MESH_INSTANCED_SPHERE + lod;
+        glm::mat4 fit = targetMesh >= 0 ? targetFits[targetMesh] : glm::mat4(1.0f);
+        if (batches.lodCount[lod] > 0)
+            queue.Push(PROGRAM_INSTANCED, mesh, fit, glm::vec3(0.0f), batches.lodFirst[lod], batches.lodCount[lod]);
+    }
+}
+
+// Per-frame uniform and instance data, each uploaded once
+void Renderer::Upload() {
+    AIM_PROFILE_SCOPE("Upload");
+    AIM_PROFILE_GPU_SCOPE(gpuProfiler, "Upload");
+
+    // Per-frame camera data, shared by every program through the uniform block
+    glm::mat4 cameraData[3] = { view, projection, projection * view };
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(cameraData), cameraData);
+
+    // All instance data for the frame goes up in one upload
+    if (!frameInstances.empty()) {
+        int count = static_cast<int>(frameInstances.size());
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        if (count > instanceCapacity) {
+            // Grow geometrically so a slowly rising count does not keep changing the size
+            instanceCapacity = count + count / 2;
+        }
+        // Orphan the previous frame's storage instead of waiting for the GPU to release it
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(SphereInstance), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(SphereInstance), frameInstances.data());
+    }
 }
 
 void Renderer::EndFrame() {
-    // Handled in main: glfwSwapBuffers
-}
\ No newline at end of file
+    AIM_PROFILE_SCOPE("Renderer::EndFrame");
+    Upload();
+
+    {
+        AIM_PROFILE_SCOPE("Sort");
+        queue.Sort();
+    }
+
+    AIM_PROFILE_SCOPE("Submit");
+    AIM_PROFILE_GPU_SCOPE(gpuProfiler, "Draw");
+
+    // Only touch state that differs from the previous draw
+    int currentProgram = -1;
+    unsigned int currentVao = 0;
+    glm::vec3 currentColor(-1.0f);
+    for (const DrawCommand& command : queue.Commands()) {
+        int programSlot = RenderQueue::KeyProgram(command.key);
+        int meshSlot = RenderQueue::KeyMesh(command.key);
+        const ProgramInfo& program = programs[programSlot];
+        const MeshInfo& mesh = meshes[meshSlot];
+
+        if (programSlot != currentProgram) {
+            glUseProgram(program.id);
+            currentProgram = programSlot;
+            currentColor = glm::vec3(-1.0f);
+            stats.programBinds++;
+        }
+        // Sphere LODs share one VAO and differ only in their index range
+        if (mesh.vao != currentVao) {
+            glBindVertexArray(mesh.vao);
+            currentVao = mesh.vao;
+            stats.vaoBinds++;
+        }
+        const void* firstIndex = (const void*)(mesh.firstIndex * sizeof(unsigned int));
+
+        if (command.instanceCount > 0) {
+            // No base-instance in GL 3.3, so point the instance attributes at this batch
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            size_t offset = command.instanceOffset * sizeof(SphereInstance);
+            glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)(offset + offsetof(SphereInstance, position)));
+            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void*)(offset + offsetof(SphereInstance, color)));
+            glUniformMatrix4fv(program.modelLocation, 1, GL_FALSE, glm::value_ptr(command.model));
+            glDrawElementsInstanced(GL_TRIANGLES, mesh.count, GL_UNSIGNED_INT, firstIndex, command.instanceCount);
+            stats.instances += command.instanceCount;
+            stats.vertices += mesh.count * command.instanceCount;
+        }
+        else {
+            glUniformMatrix4fv(program.modelLocation, 1, GL_FALSE, glm::value_ptr(command.model));
+            if (command.color != currentColor) {
+                glUniform3f(program.colorLocation, command.color.r, command.color.g, command.color.b);
+                currentColor = command.color;
+            }
+            if (mesh.indexed) glDrawElements(GL_TRIANGLES, mesh.count, GL_UNSIGNED_INT, firstIndex);
+            else glDrawArrays(GL_TRIANGLES, 0, mesh.count);
+            stats.instances++;
+            stats.vertices += mesh.count;
+        }
+        stats.drawCalls++;
+    }
+    glBindVertexArray(0);
+
+    // Scale the scene up to the output with a filtered full-screen draw. A scaling
+    // glBlitFramebuffer would do the same, but software rasterizers run it far slower.
+    if (renderWidth != viewportWidth || renderHeight != viewportHeight) {
+        AIM_PROFILE_SCOPE("Upscale");
+        glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+        glViewport(0, 0, viewportWidth, viewportHeight);
+        glDisable(GL_DEPTH_TEST);
+        glUseProgram(upscaleProgram);
+        glUniform2f(upscaleSizeLocation, (float)renderWidth / sceneWidth, (float)renderHeight / sceneHeight);
+        glUniform2f(upscaleClampLocation, (renderWidth - 0.5f) / sceneWidth, (renderHeight - 0.5f) / sceneHeight);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, sceneColor);
+        glBindVertexArray(upscaleVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glEnable(GL_DEPTH_TEST);
+        stats.drawCalls++;
+    }
+    glQueryCounter(frameQueries[frameQuerySlot][1], GL_TIMESTAMP);
+    // Presenting is handled by the caller: glfwSwapBuffers in main
+}
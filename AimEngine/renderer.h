@@ -1,18 +1,158 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <vector>
+#include "render_queue.h"
+#include "gpu_profiler.h"
+#include "sphere_batcher.h"
 
+struct RenderStats {
+    int drawCalls = 0;
+    int instances = 0;
+    int programBinds = 0;
+    int vaoBinds = 0;
+    int vertices = 0; // Vertices submitted (indices drawn, times instances)
+    int visible = 0;  // Spheres that passed frustum culling
+    int culled = 0;   // Spheres dropped by it
+    int renderWidth = 0, renderHeight = 0; // Resolution the scene was drawn at
+};
+
+class ProgramCache;
+class MeshAsset;
+
+// Every sphere LOD in one vertex and one index buffer, finest first. Building it needs no
+// GL context, so it can run on another thread while the window is created.
+struct SphereLodMeshes {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    int firstIndex[SphereBatcher::LOD_COUNT];
+    int indexCount[SphereBatcher::LOD_COUNT];
+};
+
+// Draw calls are recorded during the frame and submitted in EndFrame, sorted by
+// program, mesh and color so redundant GL state changes can be skipped.
 class Renderer {
 public:
-    void Init();
+    // Programs come from programCache when given and sphere geometry from sphereMeshes;
+    // without them both are built here
+    void Init(ProgramCache* programCache = nullptr, const SphereLodMeshes* sphereMeshes = nullptr);
+    static void BuildSphereMeshes(SphereLodMeshes& out);
+    // Size of the framebuffer frames are presented in
+    void SetViewport(int width, int height);
+    // Fraction of the viewport's width and height the scene is drawn at, clamped to
+    // [MIN_RENDER_SCALE, 1]. Below 1 the scene goes to an offscreen target and is scaled up
+    // to the viewport at the end of the frame. Takes effect at the next BeginFrame.
+    void SetRenderScale(float scale);
+    float GetRenderScale() const { return renderScale; }
+    // GPU time of a recent frame from BeginFrame to the end of EndFrame, in ms, and the render
+    // scale it was drawn at. Read back a few frames late so the CPU never waits; negative
+    // until the first result arrives.
+    double GetGpuFrameMs() const { return gpuFrameMs; }
+    float GetGpuFrameScale() const { return gpuFrameScale; }
+    static constexpr float MIN_RENDER_SCALE = 0.25f;
     void BeginFrame();
-    void DrawCube(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& color = glm::vec3(0.3f, 0.3f, 1.0f));
-    void DrawSphere(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
+    // Camera for everything drawn this frame; uploaded once to a shared uniform buffer.
+    // Must come before the Draw calls, which cull spheres and pick their LODs with it.
+    void SetCamera(const glm::mat4& view, const glm::mat4& projection);
+    void DrawCube(const glm::mat4& model, const glm::vec3& color = glm::vec3(0.3f, 0.3f, 1.0f));
+    void DrawSphere(const glm::mat4& model, const glm::vec3& color = glm::vec3(1.0f, 0.3f, 0.3f));
+    // Draws the spheres inside the view frustum, one call per LOD; the model-view-projection
+    // is built in the vertex shader
+    void DrawSpheresInstanced(const SphereInstance* instances, int count);
+
+    // Uploads a loaded model and returns its handle for DrawMesh, or -1 once
+    // MAX_CUSTOM_MESHES are in use. The asset is not needed afterwards.
+    int AddMesh(const MeshAsset& mesh);
+    void DrawMesh(int mesh, const glm::mat4& model, const glm::vec3& color);
+    // Draws targets with a model from AddMesh instead of the sphere LODs, or with the spheres
+    // again for -1. The model is centered on its bounds and scaled to fit the target's
+    // sphere, which it is culled as.
+    void SetTargetMesh(int mesh) { targetMesh = mesh; }
+    static const int MAX_CUSTOM_MESHES = 8;
+    // Large instanced batches are culled and sorted across the job system's threads
+    void SetJobSystem(JobSystem* jobs) { this->jobs = jobs; }
     void EndFrame();
 
+    // Scratch memory for the current frame, freed by the next BeginFrame
+    FrameArena& FrameMemory() { return frameArena; }
+
+    const RenderStats& GetStats() const { return stats; }
+
 private:
-    unsigned int shaderProgram;
-    unsigned int sphereVAO, sphereVBO;
-    int sphereVerticesCount;
-    unsigned int cubeVAO, cubeVBO, cubeEBO; // Buffers for the cube
-    int cubeVerticesCount; // Number of vertices for the cube (using indices)
+    // Icosphere subdivisions per LOD, finest first (1280, 320, 80 and 20 triangles); the
+    // batcher decides which one each sphere gets
+    static const int SPHERE_LOD_COUNT = SphereBatcher::LOD_COUNT;
+    static constexpr int SPHERE_LOD_SUBDIVISIONS[SPHERE_LOD_COUNT] = { 3, 2, 1, 0 };
+
+    // Enough for batching about 100k spheres before the arena has to grow
+    static const size_t FRAME_ARENA_BYTES = 4 << 20;
+
+    enum ProgramSlot { PROGRAM_BASIC, PROGRAM_INSTANCED, PROGRAM_COUNT };
+    enum MeshSlot {
+        MESH_SPHERE,                                             // + LOD
+        MESH_CUBE = MESH_SPHERE + SPHERE_LOD_COUNT,
+        MESH_INSTANCED_SPHERE,                                   // + LOD
+        MESH_CUSTOM = MESH_INSTANCED_SPHERE + SPHERE_LOD_COUNT,  // + 2 * handle, then its instanced VAO
+        MESH_COUNT = MESH_CUSTOM + 2 * MAX_CUSTOM_MESHES
+    };
+
+    struct ProgramInfo {
+        unsigned int id;
+        int modelLocation;
+        int colorLocation;
+    };
+
+    struct MeshInfo {
+        unsigned int vao;
+        int count;      // Indices, or vertices when not indexed
+        bool indexed;
+        int firstIndex; // Start of the mesh in its index buffer
+    };
+
+    ProgramInfo programs[PROGRAM_COUNT];
+    MeshInfo meshes[MESH_COUNT];
+    unsigned int sphereVBO, sphereEBO; // Every sphere LOD
+    unsigned int cubeVBO, cubeEBO; // Buffers for the cube
+    unsigned int instanceVBO;
+    int customMeshes = 0;
+    int targetMesh = -1; // Handle from AddMesh, or -1 for the sphere LODs
+    glm::mat4 targetFits[MAX_CUSTOM_MESHES]; // Model to unit sphere, per AddMesh handle
+    int instanceCapacity = 0; // Instances the instance VBO can currently hold
+    unsigned int cameraUBO;
+
+    RenderQueue queue;
+    std::vector<SphereInstance> frameInstances;
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    RenderStats stats;
+    int viewportWidth = 1, viewportHeight = 1;
+    float renderScale = 1.0f;
+    int renderWidth = 1, renderHeight = 1; // This frame's scene resolution
+
+    // Offscreen scene target at the viewport's full size; scaled frames use its lower left
+    // corner, so changing the scale never reallocates it
+    unsigned int sceneFBO = 0, sceneColor = 0, sceneDepth = 0;
+    int sceneWidth = 0, sceneHeight = 0;
+    unsigned int outputFramebuffer = 0; // Bound when Init ran: the window's, or a headless FBO
+    unsigned int upscaleProgram = 0, upscaleVAO = 0;
+    int upscaleSizeLocation = -1, upscaleClampLocation = -1;
+
+    // GL_TIMESTAMP pairs around each frame, resolved FRAMES_IN_FLIGHT frames later
+    static const int FRAMES_IN_FLIGHT = 4;
+    unsigned int frameQueries[FRAMES_IN_FLIGHT][2];
+    float frameQueryScale[FRAMES_IN_FLIGHT] = {};
+    bool frameQueryIssued[FRAMES_IN_FLIGHT] = {};
+    int frameQuerySlot = 0;
+    double gpuFrameMs = -1.0;
+    float gpuFrameScale = 1.0f;
+
+    SphereBatcher batcher;
+    FrameArena frameArena{ FRAME_ARENA_BYTES };
+    JobSystem* jobs = nullptr;
+
+    void Upload();
+    void ResizeSceneTarget(int width, int height);
+
+#ifdef AIM_PROFILE
+    GpuProfiler gpuProfiler;
+#endif
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+// Picks the render scale that keeps GPU frame time inside a budget. A frame's cost is
+// taken to grow with the pixels drawn, the scale squared, so one measurement says which
+// scale would have fit. Over budget the scale drops straight there, answering a spike on
+// the next frame; under the target it climbs back a step per frame, so it settles instead
+// of bouncing between a scale that fits and one that does not.
+class ResolutionController {
+public:
+    // A budget of 0 or less keeps the scale at 1
+    explicit ResolutionController(double budgetMs = 0.0, float minScale = 0.5f)
+        : budgetMs(budgetMs), minScale(minScale) {}
+
+    void SetBudget(double ms) { budgetMs = ms; }
+    double Budget() const { return budgetMs; }
+
+    // frameMs is a measured frame and frameScale the scale it was drawn at, which lags the
+    // current one when timings arrive late; the same late sample cannot push the scale
+    // down twice. Returns the scale for the next frame.
+    float Update(double frameMs, float frameScale) {
+        if (budgetMs <= 0.0) {
+            scale = 1.0f;
+            return scale;
+        }
+        if (frameMs <= 0.0) return scale;
+
+        double target = budgetMs * TARGET_FRACTION;
+        float fits = static_cast<float>(frameScale * std::sqrt(target / frameMs));
+        if (frameMs > budgetMs) scale = std::min(scale, fits);
+        else if (frameMs < target) scale = std::max(scale, std::min(fits, scale + MAX_RAISE));
+        // Just under full scale saves too few pixels to pay for the upscale pass
+        if (scale > FULL_SCALE_SNAP && scale < 1.0f) scale = fits >= 1.0f ? 1.0f : FULL_SCALE_SNAP;
+        scale = std::max(minScale, std::min(1.0f, scale));
+        return scale;
+    }
+
+    float Scale() const { return scale; }
+
+private:
+    // Aim below the budget so ordinary frame-to-frame noise does not cross it
+    static constexpr double TARGET_FRACTION = 0.85;
+    // Largest step up per frame: from half to full scale in about a second at 60 fps
+    static constexpr float MAX_RAISE = 0.01f;
+    // Highest scale below 1; going above it goes all the way once full scale would fit
+    static constexpr float FULL_SCALE_SNAP = 0.95f;
+
+    double budgetMs;
+    float minScale;
+    float scale = 1.0f;
+};
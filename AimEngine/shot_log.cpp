@@ -0,0 +1,234 @@
+#include "shot_log.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static const char SHOT_LOG_MAGIC[4] = { 'A', 'I', 'M', 'S' };
+static const uint32_t SHOT_LOG_VERSION = 1;
+
+// Blocks start after this much header so they can be mapped one at a time
+static const uint64_t HEADER_BYTES = MappedAppendFile::MAP_ALIGNMENT;
+// Each column starts on its own cache line within a block
+static const uint32_t COLUMN_ALIGNMENT = 64;
+// How often the writer thread picks up new shots
+static const std::chrono::milliseconds WRITER_INTERVAL(5);
+
+static_assert(sizeof(int) == 4 && sizeof(bool) == 1, "shot log columns assume 4-byte int and 1-byte bool");
+
+// Fixed-width, little-endian, at the start of the file
+struct ShotLogHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t columnCount;
+    uint32_t rowsPerBlock;
+    uint64_t headerBytes;
+    uint64_t blockBytes;
+    uint64_t rows; // Rows fully written; the writer raises it after the data is in place
+    uint64_t seed;
+};
+
+// Follows the header, one per column
+struct ShotLogColumn {
+    char name[16];
+    uint32_t size;   // Bytes per value
+    uint32_t offset; // Start of the column within a block
+};
+
+// Columns in file order; writer and reader share the list so they cannot drift
+template <typename Record, typename Visit>
+static void VisitColumns(Record& shot, Visit visit) {
+    visit(ShotColumn::TIME, "time", &shot.time, sizeof(shot.time));
+    visit(ShotColumn::YAW, "yaw", &shot.yaw, sizeof(float));
+    visit(ShotColumn::PITCH, "pitch", &shot.pitch, sizeof(float));
+    visit(ShotColumn::ORIGIN_X, "origin_x", &shot.origin.x, sizeof(float));
+    visit(ShotColumn::ORIGIN_Y, "origin_y", &shot.origin.y, sizeof(float));
+    visit(ShotColumn::ORIGIN_Z, "origin_z", &shot.origin.z, sizeof(float));
+    visit(ShotColumn::DIRECTION_X, "direction_x", &shot.direction.x, sizeof(float));
+    visit(ShotColumn::DIRECTION_Y, "direction_y", &shot.direction.y, sizeof(float));
+    visit(ShotColumn::DIRECTION_Z, "direction_z", &shot.direction.z, sizeof(float));
+    visit(ShotColumn::TARGET, "target", &shot.target, sizeof(shot.target));
+    visit(ShotColumn::HIT, "hit", &shot.hit, sizeof(shot.hit));
+    visit(ShotColumn::MISS_DISTANCE, "miss_distance", &shot.missDistance, sizeof(float));
+    visit(ShotColumn::REACTION_TIME, "reaction_time", &shot.reactionTime, sizeof(float));
+}
+
+namespace {
+
+struct BlockLayout {
+    uint32_t offsets[static_cast<int>(ShotColumn::COUNT)];
+    uint64_t blockBytes;
+
+    BlockLayout() {
+        uint64_t offset = 0;
+        ShotRecord shot = {};
+        VisitColumns(shot, [&](ShotColumn column, const char*, const void*, uint32_t size) {
+            offsets[static_cast<int>(column)] = static_cast<uint32_t>(offset);
+            offset += static_cast<uint64_t>(size) * ShotLog::ROWS_PER_BLOCK;
+            offset = (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+        });
+        blockBytes = (offset + HEADER_BYTES - 1) / HEADER_BYTES * HEADER_BYTES;
+    }
+};
+
+const BlockLayout layout;
+
+}
+
+bool ShotLog::Open(const char* path, uint64_t seed) {
+    Close();
+    if (!file.Create(path)) return false;
+    size_t headerSize = sizeof(ShotLogHeader) + sizeof(ShotLogColumn) * static_cast<int>(ShotColumn::COUNT);
+    header = file.Map(0, headerSize);
+    if (!header) {
+        file.Close();
+        return false;
+    }
+
+    // The file starts zero-filled, so names are terminated and rows starts at 0
+    ShotLogHeader* fileHeader = reinterpret_cast<ShotLogHeader*>(header);
+    std::memcpy(fileHeader->magic, SHOT_LOG_MAGIC, sizeof(SHOT_LOG_MAGIC));
+    fileHeader->version = SHOT_LOG_VERSION;
+    fileHeader->columnCount = static_cast<uint32_t>(ShotColumn::COUNT);
+    fileHeader->rowsPerBlock = ROWS_PER_BLOCK;
+    fileHeader->headerBytes = HEADER_BYTES;
+    fileHeader->blockBytes = layout.blockBytes;
+    fileHeader->seed = seed;
+    ShotLogColumn* columns = reinterpret_cast<ShotLogColumn*>(header + sizeof(ShotLogHeader));
+    ShotRecord shot = {};
+    VisitColumns(shot, [&](ShotColumn column, const char* name, const void*, uint32_t size) {
+        ShotLogColumn& entry = columns[static_cast<int>(column)];
+        std::strncpy(entry.name, name, sizeof(entry.name) - 1);
+        entry.size = size;
+        entry.offset = layout.offsets[static_cast<int>(column)];
+    });
+
+    blocks = 0;
+    rows = 0;
+    failed = false;
+    running = true;
+    writer = std::thread(&ShotLog::WriterLoop, this);
+    return true;
+}
+
+void ShotLog::Append(const ShotRecord& shot) {
+    if (!IsOpen()) return;
+    // Shots still waiting from earlier go first, keeping the file in shot order
+    size_t sent = 0;
+    while (sent < overflow.size() && queue.Push(overflow[sent])) ++sent;
+    overflow.erase(overflow.begin(), overflow.begin() + sent);
+    if (!overflow.empty() || !queue.Push(shot)) overflow.push_back(shot);
+}
+
+void ShotLog::Close() {
+    if (!IsOpen()) return;
+    for (const ShotRecord& shot : overflow) {
+        while (!queue.Push(shot)) std::this_thread::yield();
+    }
+    overflow.clear();
+    running.store(false, std::memory_order_release);
+    writer.join();
+
+    size_t headerSize = sizeof(ShotLogHeader) + sizeof(ShotLogColumn) * static_cast<int>(ShotColumn::COUNT);
+    MappedAppendFile::Unmap(block, layout.blockBytes);
+    MappedAppendFile::Unmap(header, headerSize);
+    block = nullptr;
+    header = nullptr;
+    file.Close();
+}
+
+void ShotLog::WriterLoop() {
+    AIM_PROFILE_THREAD("Shot log");
+    while (true) {
+        // Checked before draining, so everything appended before Close gets written
+        bool stopping = !running.load(std::memory_order_acquire);
+        uint64_t before = rows;
+        ShotRecord shot;
+        while (queue.Pop(shot)) {
+            WriteRow(shot);
+        }
+        if (rows != before) CommitRows();
+        if (stopping) return;
+        std::this_thread::sleep_for(WRITER_INTERVAL);
+    }
+}
+
+bool ShotLog::WriteRow(const ShotRecord& shot) {
+    if (failed) return false;
+    uint64_t row = rows % ROWS_PER_BLOCK;
+    if (row == 0) {
+        MappedAppendFile::Unmap(block, layout.blockBytes);
+        block = file.Map(HEADER_BYTES + blocks * layout.blockBytes, layout.blockBytes);
+        if (!block) {
+            failed = true;
+            return false;
+        }
+        blocks++;
+    }
+    VisitColumns(shot, [&](ShotColumn column, const char*, const void* field, uint32_t size) {
+        std::memcpy(block + layout.offsets[static_cast<int>(column)] + row * size, field, size);
+    });
+    rows++;
+    return true;
+}
+
+void ShotLog::CommitRows() {
+    reinterpret_cast<ShotLogHeader*>(header)->rows = rows;
+}
+
+bool ShotLogReader::Open(const char* path) {
+    if (!file.Open(path)) return false;
+
+    ShotLogHeader fileHeader;
+    if (file.Size() < sizeof(fileHeader)) {
+        std::cout << "ERROR::SHOT_LOG::INVALID_HEADER\n" << path << std::endl;
+        return false;
+    }
+    std::memcpy(&fileHeader, file.Data(), sizeof(fileHeader));
+    size_t columnsEnd = sizeof(fileHeader) + sizeof(ShotLogColumn) * static_cast<size_t>(fileHeader.columnCount);
+    if (std::memcmp(fileHeader.magic, SHOT_LOG_MAGIC, sizeof(SHOT_LOG_MAGIC)) != 0 || fileHeader.version > SHOT_LOG_VERSION ||
+        fileHeader.rowsPerBlock == 0 || fileHeader.headerBytes < columnsEnd || file.Size() < columnsEnd) {
+        std::cout << "ERROR::SHOT_LOG::INVALID_HEADER\n" << path << std::endl;
+        return false;
+    }
+
+    const ShotLogColumn* columns = reinterpret_cast<const ShotLogColumn*>(file.Data() + sizeof(fileHeader));
+    bool complete = true;
+    ShotRecord shot = {};
+    VisitColumns(shot, [&](ShotColumn column, const char* name, const void*, uint32_t size) {
+        for (uint32_t i = 0; i < fileHeader.columnCount; ++i) {
+            if (std::strncmp(columns[i].name, name, sizeof(columns[i].name)) == 0 && columns[i].size == size &&
+                columns[i].offset + static_cast<uint64_t>(size) * fileHeader.rowsPerBlock <= fileHeader.blockBytes) {
+                columnOffsets[static_cast<int>(column)] = columns[i].offset;
+                return;
+            }
+        }
+        std::cout << "ERROR::SHOT_LOG::MISSING_COLUMN\n" << name << std::endl;
+        complete = false;
+    });
+    if (!complete) return false;
+
+    rowsPerBlock = fileHeader.rowsPerBlock;
+    headerBytes = fileHeader.headerBytes;
+    blockBytes = fileHeader.blockBytes;
+    seed = fileHeader.seed;
+    // A log cut short by a crash still reads up to its last whole block
+    uint64_t blocksInFile = file.Size() > headerBytes ? (file.Size() - headerBytes) / blockBytes : 0;
+    rows = std::min(fileHeader.rows, blocksInFile * rowsPerBlock);
+    return true;
+}
+
+int ShotLogReader::BlockRows(uint64_t block) const {
+    return static_cast<int>(std::min<uint64_t>(rowsPerBlock, rows - block * rowsPerBlock));
+}
+
+ShotRecord ShotLogReader::Row(uint64_t row) const {
+    ShotRecord shot = {};
+    const unsigned char* data = file.Data() + BlockOffset(row / rowsPerBlock);
+    uint64_t index = row % rowsPerBlock;
+    VisitColumns(shot, [&](ShotColumn column, const char*, void* field, uint32_t size) {
+        std::memcpy(field, data + columnOffsets[static_cast<int>(column)] + index * size, size);
+    });
+    return shot;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "mapped_file.h"
+#include "spsc_queue.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Everything known about one resolved shot
+struct ShotRecord {
+    double time;         // Simulation clock at the click, seconds
+    float yaw, pitch;    // Camera the shot was fired from, degrees
+    glm::vec3 origin;
+    glm::vec3 direction; // Unit length
+    int target;          // Target hit, or on a miss the one the ray passed closest to; -1 if none
+    bool hit;
+    float missDistance;  // Gap between the ray and the target's surface; 0 on a hit
+    float reactionTime;  // Seconds since the target spawned; the time to kill on a hit
+};
+
+enum class ShotColumn {
+    TIME, YAW, PITCH,
+    ORIGIN_X, ORIGIN_Y, ORIGIN_Z,
+    DIRECTION_X, DIRECTION_Y, DIRECTION_Z,
+    TARGET, HIT, MISS_DISTANCE, REACTION_TIME,
+    COUNT
+};
+
+// Append-only columnar shot log. The file is a header followed by fixed-size blocks of
+// rows, each holding one contiguous array per column, so a query over one field reads only
+// that field. The header names every column with its size and offset in a block, and
+// counts the rows written so far.
+//
+// Append only copies the shot into a queue; a background thread writes it into the mapped
+// block, so the simulation never waits on the disk.
+class ShotLog {
+public:
+    ~ShotLog() { Close(); }
+
+    bool Open(const char* path, uint64_t seed);
+    // Simulation thread only. Never blocks: if the writer has fallen far behind, shots wait
+    // in memory until the queue has room, so none are lost.
+    void Append(const ShotRecord& shot);
+    // Writes every shot appended so far and closes the file
+    void Close();
+
+    bool IsOpen() const { return writer.joinable(); }
+
+    static const int ROWS_PER_BLOCK = 16384;
+
+private:
+    MappedAppendFile file;
+    unsigned char* header = nullptr;
+    unsigned char* block = nullptr;
+    uint64_t blocks = 0;
+    uint64_t rows = 0;
+    bool failed = false; // The file could not grow; later shots are dropped
+
+    SpscQueue<ShotRecord, 1024> queue;
+    std::vector<ShotRecord> overflow; // Producer side, in order, when the queue is full
+    std::thread writer;
+    std::atomic<bool> running{ false };
+
+    void WriterLoop();
+    bool WriteRow(const ShotRecord& shot);
+    void CommitRows();
+};
+
+// Reads a shot log through a memory mapping. Columns are found by name, so logs with more
+// columns than this build knows about still read.
+class ShotLogReader {
+public:
+    bool Open(const char* path);
+
+    uint64_t Rows() const { return rows; }
+    uint64_t Seed() const { return seed; }
+    uint64_t Blocks() const { return (rows + rowsPerBlock - 1) / rowsPerBlock; }
+    int BlockRows(uint64_t block) const;
+
+    // One column of one block: BlockRows(block) values of the column's type
+    // (double for TIME, int32_t for TARGET, uint8_t for HIT, float otherwise)
+    template <typename T>
+    const T* Column(ShotColumn column, uint64_t block) const {
+        return reinterpret_cast<const T*>(file.Data() + BlockOffset(block) + columnOffsets[static_cast<int>(column)]);
+    }
+
+    ShotRecord Row(uint64_t row) const;
+
+private:
+    MappedFile file;
+    uint64_t rows = 0;
+    uint64_t seed = 0;
+    uint32_t rowsPerBlock = 1;
+    uint64_t headerBytes = 0;
+    uint64_t blockBytes = 0;
+    uint32_t columnOffsets[static_cast<int>(ShotColumn::COUNT)] = {};
+
+    uint64_t BlockOffset(uint64_t block) const { return headerBytes + block * blockBytes; }
+};
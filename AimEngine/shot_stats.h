@@ -0,0 +1,78 @@
+#pragma once
+#include "shot_log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Session aggregates kept up to date one shot at a time, so they never rescan the log.
+// Times to kill go into a histogram with 32 log-spaced buckets per doubling; a percentile
+// walks its buckets and is within about 1% of the exact value.
+class ShotStats {
+public:
+    struct Summary {
+        int shots = 0;
+        int hits = 0;
+        double accuracy = 0.0;        // Hits per shot
+        double timeToKillP50 = 0.0;   // Seconds from spawn to hit
+        double timeToKillP90 = 0.0;
+        double timeToKillMean = 0.0;
+        double missDistanceMean = 0.0; // World units between a missing ray and the nearest target
+    };
+
+    // O(1)
+    void Add(const ShotRecord& shot) {
+        shots++;
+        if (shot.hit) {
+            hits++;
+            timeToKillSum += shot.reactionTime;
+            buckets[Bucket(shot.reactionTime)]++;
+        }
+        else if (shot.target >= 0) {
+            misses++;
+            missDistanceSum += shot.missDistance;
+        }
+    }
+
+    // Seconds; O(BUCKETS)
+    double TimeToKillPercentile(double p) const {
+        if (hits == 0) return 0.0;
+        int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(p * hits)));
+        int64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) return MIN_SECONDS * std::exp2((i + 0.5) / BUCKETS_PER_OCTAVE);
+        }
+        return MIN_SECONDS * std::exp2(static_cast<double>(OCTAVES));
+    }
+
+    Summary Compute() const {
+        Summary summary;
+        summary.shots = shots;
+        summary.hits = hits;
+        summary.accuracy = shots > 0 ? static_cast<double>(hits) / shots : 0.0;
+        summary.timeToKillP50 = TimeToKillPercentile(0.50);
+        summary.timeToKillP90 = TimeToKillPercentile(0.90);
+        summary.timeToKillMean = hits > 0 ? timeToKillSum / hits : 0.0;
+        summary.missDistanceMean = misses > 0 ? missDistanceSum / misses : 0.0;
+        return summary;
+    }
+
+private:
+    // 1 ms to about 17 minutes; anything outside lands in the end buckets
+    static constexpr double MIN_SECONDS = 0.001;
+    static const int BUCKETS_PER_OCTAVE = 32;
+    static const int OCTAVES = 20;
+    static const int BUCKETS = BUCKETS_PER_OCTAVE * OCTAVES;
+
+    int shots = 0;
+    int hits = 0;
+    int misses = 0; // Misses with a target to measure against
+    double timeToKillSum = 0.0;
+    double missDistanceSum = 0.0;
+    uint32_t buckets[BUCKETS] = {};
+
+    static int Bucket(double seconds) {
+        if (!(seconds > MIN_SECONDS)) return 0;
+        return std::min(BUCKETS - 1, static_cast<int>(std::log2(seconds / MIN_SECONDS) * BUCKETS_PER_OCTAVE));
+    }
+};
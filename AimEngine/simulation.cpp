@@ -0,0 +1,342 @@
+#include "simulation.h"
+#include "recording.h"
+#include "profiler.h"
+#include "allocation_counter.h"
+#include "arena.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+// How long before a tick deadline the thread stops sleeping and yields instead.
+// Windows sleeps in whole scheduler quanta, so it needs a much wider margin.
+#ifdef _WIN32
+const std::chrono::microseconds SLEEP_MARGIN(2000);
+#else
+const std::chrono::microseconds SLEEP_MARGIN(200);
+#endif
+
+// Ticks the loop may fall behind (debugger, suspended machine) before it resyncs
+// to the wall clock instead of replaying every missed tick at once
+const int MAX_CATCH_UP_TICKS = 100;
+
+Simulation::Simulation(const SimConfig& config)
+    : config(config),
+      tickInterval(1.0 / config.tickRate),
+      camera(config.cameraStart),
+      targetManager(config.targetCount, config.targetMinX, config.targetMaxX, config.targetMinY, config.targetMaxY, config.targetZ, config.targetRadius, config.seed),
+      cursorX(config.screenWidth / 2.0f),
+      cursorY(config.screenHeight / 2.0f),
+      epoch(std::chrono::steady_clock::now()) {
+    if (config.targetMotion != MotionPattern::STATIC) {
+        targetManager.SetMotion(config.targetMotion, config.targetSpeed, config.targetPathSize);
+    }
+    // A tick takes at most a queue's worth of input, so these never grow while running
+    tickEvents.reserve(INPUT_QUEUE_CAPACITY);
+    pendingShots.reserve(INPUT_QUEUE_CAPACITY);
+    // A longer sweep than the history holds looks back as far as it goes
+    if (config.sweepSeconds > 0.0f) {
+        double views = std::ceil(static_cast<double>(config.sweepSeconds) * CameraHistory::MAX_MOUSE_RATE) + 1.0;
+        size_t capacity = static_cast<size_t>(std::min(views, static_cast<double>(CameraHistory::VIEW_CAPACITY)));
+        sweepViews.resize(capacity);
+        sweepDirections.resize(capacity);
+    }
+    previousPositions.resize(targetManager.targets.size());
+    spawnTimes.assign(targetManager.targets.size(), 0.0);
+    for (size_t i = 0; i < targetManager.targets.size(); ++i) {
+        previousPositions[i] = targetManager.targets[i].position;
+    }
+    if (config.arenaOcclusion) {
+        for (const ArenaBox& box : ARENA_BOXES) {
+            world.AddBox(box.center - 0.5f * box.size, box.center + 0.5f * box.size);
+        }
+    }
+    world.Build();
+    previousCameraPosition = camera.Position;
+    previousYaw = camera.Yaw;
+    previousPitch = camera.Pitch;
+    history.RecordView(0.0, camera.Yaw, camera.Pitch, cursorX, cursorY);
+    history.RecordPosition(0.0, camera.Position);
+
+    // The render thread always has a snapshot to draw, even before the first tick
+    Publish();
+}
+
+Simulation::~Simulation() {
+    Stop();
+}
+
+void Simulation::Start() {
+    if (running.exchange(true)) return;
+    thread = std::thread(&Simulation::Run, this);
+}
+
+void Simulation::Stop() {
+    running = false;
+    if (thread.joinable()) thread.join();
+}
+
+bool Simulation::PushInput(const InputEvent& event) {
+    return inputQueue.Push(event);
+}
+
+const SimSnapshot& Simulation::LatestSnapshot() {
+    snapshots.Acquire();
+    return snapshots.ReadBuffer();
+}
+
+double Simulation::Now() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Simulation::Run() {
+    AIM_PROFILE_THREAD("Simulation");
+    while (running.load(std::memory_order_relaxed)) {
+        double now = Now();
+        if (now - TickTime(tick + 1) > MAX_CATCH_UP_TICKS * tickInterval) {
+            Resync(std::llround((now - static_cast<double>(tick + 1) * tickInterval) * 1e6));
+        }
+
+        // Sleep for the bulk of the wait, then yield until the deadline for precision
+        std::chrono::duration<double> wait;
+        while ((wait = std::chrono::duration<double>(TickTime(tick + 1) - Now())).count() > 0.0) {
+            if (wait > SLEEP_MARGIN) std::this_thread::sleep_for(wait - SLEEP_MARGIN);
+            else std::this_thread::yield();
+        }
+
+        Tick();
+    }
+}
+
+void Simulation::Tick() {
+    tickEvents.clear();
+    InputEvent event;
+    while (inputQueue.Pop(event)) {
+        tickEvents.push_back(event);
+    }
+    Step(tickEvents);
+}
+
+void Simulation::Step(const std::vector<InputEvent>& events) {
+    AIM_PROFILE_SCOPE("Simulation::Step");
+    uint64_t allocationsBefore = AllocationCounter::ThreadAllocations();
+    // Static targets only move when they respawn, which sets their previous position too
+    if (config.targetMotion != MotionPattern::STATIC) {
+        for (size_t i = 0; i < targetManager.targets.size(); ++i) {
+            previousPositions[i] = targetManager.targets[i].position;
+        }
+    }
+    previousCameraPosition = camera.Position;
+    previousYaw = camera.Yaw;
+    previousPitch = camera.Pitch;
+
+    // Clicks wait until the tick has moved the camera, so the position history covers
+    // their timestamps
+    pendingShots.clear();
+    for (InputEvent event : events) {
+        event.time = std::llround(event.time * 1e6) * 1e-6;
+        if (recorder) recorder->Write(tick + 1, event);
+        Apply(event);
+    }
+    camera.ProcessKeyboard(keys, static_cast<float>(tickInterval));
+    {
+        AIM_PROFILE_SCOPE("TargetManager::Advance");
+        targetManager.Advance(static_cast<float>(tickInterval), jobs);
+    }
+    tick++;
+    history.RecordPosition(TickTime(tick), camera.Position);
+    if (config.targetMotion != MotionPattern::STATIC) allTargetsChangedTick = tick;
+
+    for (const InputEvent& click : pendingShots) {
+        ResolveShot(click);
+    }
+
+    if (AllocationCounter::ThreadAllocations() != allocationsBefore) {
+        allocatingTicks++;
+        lastAllocatingTick = tick;
+    }
+    Publish();
+}
+
+void Simulation::Resync(int64_t clockOffsetMicros) {
+    clockOffset = clockOffsetMicros * 1e-6;
+    if (recorder) recorder->WriteResync(tick + 1, clockOffsetMicros);
+}
+
+void Simulation::Apply(const InputEvent& event) {
+    switch (event.type) {
+    case InputEvent::MOUSE_MOVE:
+        if (firstMouse) {
+            rawCursorX = event.rawX;
+            rawCursorY = event.rawY;
+            firstMouse = false;
+        }
+        // Turned by how far the mouse moved, so the sensitivity does not change with the window size
+        camera.ProcessMouseMovement(event.rawX - rawCursorX, event.rawY - rawCursorY);
+        rawCursorX = event.rawX;
+        rawCursorY = event.rawY;
+        cursorX = event.x;
+        cursorY = event.y;
+        history.RecordView(event.time, camera.Yaw, camera.Pitch, cursorX, cursorY);
+        lastMouseTime = event.time;
+        break;
+
+    case InputEvent::KEY:
+        if (event.key >= 0 && event.key < 1024) keys[event.key] = event.pressed;
+        break;
+
+    case InputEvent::CLICK:
+        pendingShots.push_back(event);
+        break;
+    }
+}
+
+// Rebuilds the camera as it was at the click's timestamp; mouse events that arrived later
+// in the same batch have already turned the live camera
+void Simulation::ResolveShot(const InputEvent& click) {
+    AIM_PROFILE_SCOPE("Simulation::ResolveShot");
+    CameraHistory::View view = history.ViewAt(click.time);
+    Camera shotCamera(history.PositionAt(click.time));
+    shotCamera.Yaw = view.yaw;
+    shotCamera.Pitch = view.pitch;
+
+    glm::mat4 viewMatrix = shotCamera.GetViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(config.fovDegrees), config.screenWidth / config.screenHeight, config.nearPlane, config.farPlane);
+    glm::vec3 rayDirection = GetRayFromMouse(view.cursorX, view.cursorY, config.screenWidth, config.screenHeight, projection, viewMatrix);
+
+    shots++;
+    // The nearest target in the ray's way, unless a wall comes first (or at the same spot)
+    float hitDistance;
+    int id = targetManager.Raycast(shotCamera.Position, rayDirection, hitDistance);
+    if (id >= 0 && world.Occluded(shotCamera.Position, rayDirection, hitDistance)) id = -1;
+    if (id < 0 && config.sweepSeconds > 0.0f) {
+        id = SweepShot(click.time, shotCamera.Position, projection);
+        if (id >= 0) sweptHits++;
+    }
+
+    ShotRecord shot = {};
+    shot.time = click.time;
+    shot.yaw = view.yaw;
+    shot.pitch = view.pitch;
+    shot.origin = shotCamera.Position;
+    shot.direction = glm::normalize(rayDirection);
+    shot.hit = id >= 0;
+    shot.target = shot.hit ? id : targetManager.NearestMiss(shot.origin, shot.direction, shot.missDistance);
+    if (shot.target >= 0) {
+        shot.reactionTime = static_cast<float>(std::max(0.0, click.time - spawnTimes[shot.target]));
+    }
+
+    if (id >= 0) {
+        hits++;
+        targetManager.MarkHit(id);
+        targetManager.ResetHitTargets(config.targetMinX, config.targetMaxX, config.targetMinY, config.targetMaxY, config.targetZ);
+        // A respawn is a jump, not a movement to interpolate
+        previousPositions[id] = targetManager.targets[id].position;
+        TargetChanged(id);
+        spawnTimes[id] = TickTime(tick);
+    }
+
+    shotStats.Add(shot);
+    shotSummary = shotStats.Compute();
+    if (shotLog) shotLog->Append(shot);
+
+    latencyLast = Now() - click.time;
+    latencySum += latencyLast;
+    latencyMax = std::max(latencyMax, latencyLast);
+}
+
+// The rays the aim turned through in the sweep window before the click, ending with the
+// click's own, tested as one continuous turn
+int Simulation::SweepShot(double time, const glm::vec3& origin, const glm::mat4& projection) {
+    CameraHistory::View* views = sweepViews.data();
+    glm::vec3* directions = sweepDirections.data();
+    int count = history.ViewsBetween(time - config.sweepSeconds, time, views, static_cast<int>(sweepViews.size()));
+    for (int k = 0; k < count; ++k) {
+        Camera viewCamera(origin);
+        viewCamera.Yaw = views[k].yaw;
+        viewCamera.Pitch = views[k].pitch;
+        directions[k] = glm::normalize(GetRayFromMouse(views[k].cursorX, views[k].cursorY, config.screenWidth, config.screenHeight, projection, viewCamera.GetViewMatrix()));
+    }
+    float sweep;
+    int id = targetManager.SweepCast(origin, directions, count, sweep);
+    if (id < 0) return -1;
+    // The aim crossed the target, but it only counts if the target was in sight
+    const Target& target = targetManager.targets[id];
+    glm::vec3 front = target.position - target.radius * glm::normalize(target.position - origin);
+    return world.Occluded(origin, front) ? -1 : id;
+}
+
+void Simulation::TargetChanged(int id) {
+    TargetChange& change = targetChanges[targetChangeCount++ % TARGET_CHANGE_CAPACITY];
+    if (targetChangeCount > TARGET_CHANGE_CAPACITY) forgottenChangeTick = change.tick;
+    change = { tick, id };
+}
+
+void Simulation::Publish() {
+    SimSnapshot& snapshot = snapshots.WriteBuffer();
+    // The slot coming back from the triple buffer holds some earlier tick's targets
+    uint64_t filledTick = snapshot.tick;
+    snapshot.tick = tick;
+    snapshot.time = TickTime(tick);
+    snapshot.cameraPosition = camera.Position;
+    snapshot.previousCameraPosition = previousCameraPosition;
+    snapshot.yaw = camera.Yaw;
+    snapshot.pitch = camera.Pitch;
+    snapshot.previousYaw = previousYaw;
+    snapshot.previousPitch = previousPitch;
+    snapshot.lastMouseTime = lastMouseTime;
+    snapshot.shots = shots;
+    snapshot.hits = hits;
+    snapshot.sweptHits = sweptHits;
+    snapshot.registrationLatencyLast = latencyLast;
+    snapshot.registrationLatencyMean = shots > 0 ? latencySum / shots : 0.0;
+    snapshot.registrationLatencyMax = latencyMax;
+    snapshot.shotStats = shotSummary;
+    snapshot.allocatingTicks = allocatingTicks;
+    snapshot.lastAllocatingTick = lastAllocatingTick;
+
+    auto copy = [&](size_t i) {
+        const Target& target = targetManager.targets[i];
+        TargetState& state = snapshot.targets[i];
+        state.position = target.position;
+        state.previousPosition = previousPositions[i];
+        state.radius = target.radius;
+        state.hit = target.hit;
+    };
+    size_t count = targetManager.targets.size();
+    if (snapshot.targets.size() != count || filledTick < allTargetsChangedTick || filledTick < forgottenChangeTick) {
+        snapshot.targets.resize(count);
+        for (size_t i = 0; i < count; ++i) copy(i);
+    }
+    else {
+        size_t oldest = targetChangeCount - std::min(targetChangeCount, TARGET_CHANGE_CAPACITY);
+        for (size_t k = targetChangeCount; k > oldest; --k) {
+            const TargetChange& change = targetChanges[(k - 1) % TARGET_CHANGE_CAPACITY];
+            if (change.tick <= filledTick) break;
+            copy(change.id);
+        }
+    }
+    snapshots.Publish();
+}
+
+uint64_t Simulation::StateHash() const {
+    // FNV-1a over the raw bytes: a replay matches only if every float matches bit for bit
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    mix(&tick, sizeof(tick));
+    mix(&shots, sizeof(shots));
+    mix(&hits, sizeof(hits));
+    mix(&camera.Position, sizeof(camera.Position));
+    mix(&camera.Yaw, sizeof(camera.Yaw));
+    mix(&camera.Pitch, sizeof(camera.Pitch));
+    for (const Target& target : targetManager.targets) {
+        unsigned char hit = target.hit ? 1 : 0;
+        mix(&target.position, sizeof(target.position));
+        mix(&hit, 1);
+    }
+    return hash;
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "camera.h"
+#include "camera_history.h"
+#include "target_manager.h"
+#include "collision_world.h"
+#include "triple_buffer.h"
+#include "spsc_queue.h"
+#include "shot_stats.h"
+
+class InputRecorder;
+
+struct SimConfig {
+    int tickRate = 1000;
+    uint64_t seed = 1; // Target placement; a recording stores it with the input
+
+    // Scenario
+    float targetMinX = -5.0f;
+    float targetMaxX = 5.0f;
+    float targetMinY = 1.0f;
+    float targetMaxY = 6.0f;
+    float targetZ = -10.0f;
+    float targetRadius = 0.25f;
+    int targetCount = 10;
+    MotionPattern targetMotion = MotionPattern::STATIC;
+    float targetSpeed = 3.0f;    // World units per second
+    float targetPathSize = 1.5f; // How far a moving target strays from its spawn point
+    // Continuous hit detection: a click that misses still hits a target the aim swept
+    // across in this many seconds before it. 0 tests only the ray at the click.
+    float sweepSeconds = 0.0f;
+    // Arena walls and ground stop shots. Off only to replay recordings made before they did.
+    bool arenaOcclusion = true;
+    glm::vec3 cameraStart = glm::vec3(0.0f, 0.0f, 3.0f);
+
+    // View used to turn a click position into a ray
+    float screenWidth = 1920.0f;
+    float screenHeight = 1080.0f;
+    float fovDegrees = 45.0f;
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+};
+
+struct InputEvent {
+    enum Type { MOUSE_MOVE, KEY, CLICK };
+    Type type;
+    double time;  // Simulation clock (Simulation::Now) when the window system delivered it;
+                  // kept to whole microseconds once the simulation takes it
+    int key;      // KEY
+    bool pressed; // KEY
+    float x, y;   // MOUSE_MOVE: cursor position in the simulation's screen, which shots aim through
+    float rawX, rawY; // MOUSE_MOVE: the same position in window pixels, which the camera turns by
+};
+
+struct TargetState {
+    glm::vec3 position;
+    glm::vec3 previousPosition; // Position one tick earlier, for interpolation
+    float radius;
+    bool hit;
+};
+
+// Everything the render thread needs from one simulation tick
+struct SimSnapshot {
+    uint64_t tick = 0;
+    double time = 0.0; // Seconds on the simulation clock when the tick finished
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    glm::vec3 previousCameraPosition = glm::vec3(0.0f);
+    float yaw = 0.0f, pitch = 0.0f;
+    float previousYaw = 0.0f, previousPitch = 0.0f;
+    // Timestamp of the newest mouse movement the camera has taken in, on the simulation
+    // clock; input-to-present latency is measured from it. Negative before the first.
+    double lastMouseTime = -1.0;
+    std::vector<TargetState> targets;
+    int shots = 0;
+    int hits = 0;
+    int sweptHits = 0; // Hits the click ray missed but the aim swept across
+
+    // Click to shot resolution, in seconds, over all shots so far
+    double registrationLatencyLast = 0.0;
+    double registrationLatencyMean = 0.0;
+    double registrationLatencyMax = 0.0;
+
+    // Accuracy, time to kill and miss distance over all shots so far
+    ShotStats::Summary shotStats;
+
+    // Ticks that allocated on the heap (always 0 without AIM_COUNT_ALLOCATIONS); a warmed-up
+    // session should stop adding to it
+    uint64_t allocatingTicks = 0;
+    uint64_t lastAllocatingTick = 0;
+};
+
+// Camera and target simulation running on its own thread at a fixed tick rate.
+// Input arrives through a lock-free queue and every tick is published through a
+// triple buffer, so neither side ever blocks on the other.
+class Simulation {
+public:
+    explicit Simulation(const SimConfig& config);
+    ~Simulation();
+
+    void Start();
+    void Stop();
+
+    // Called from the window thread with event.time already stamped; returns false if
+    // the queue is full
+    bool PushInput(const InputEvent& event);
+
+    // Render side: picks up the newest tick if there is one; the snapshot stays valid
+    // until the next call
+    const SimSnapshot& LatestSnapshot();
+
+    // Seconds on the simulation clock; snapshot times use the same clock
+    double Now() const;
+    double TickInterval() const { return tickInterval; }
+
+    // Runs a single tick on the calling thread (the simulation thread must not be running)
+    void Tick();
+
+    // Runs a single tick with the given input instead of the queue. Ticks depend only on
+    // the config, the clock offset and the input, so a recording replayed through Step
+    // reproduces the session exactly, at whatever speed the CPU allows.
+    void Step(const std::vector<InputEvent>& events);
+
+    // Moves the tick clock by a whole number of microseconds; the simulation thread does
+    // this after a stall instead of replaying every missed tick
+    void Resync(int64_t clockOffsetMicros);
+
+    // Every tick's input, and every resync, goes to the recorder (set before Start)
+    void SetRecorder(InputRecorder* recorder) { this->recorder = recorder; }
+
+    // Large target fields are moved across the job system's threads (set before Start).
+    // Ticks come out the same with or without it.
+    void SetJobSystem(JobSystem* jobs) { this->jobs = jobs; }
+
+    // Every resolved shot goes to the log (set before Start)
+    void SetShotLog(ShotLog* shotLog) { this->shotLog = shotLog; }
+
+    uint64_t CurrentTick() const { return tick; }
+
+    // Hash of the game state (camera, targets, score), for comparing replays
+    uint64_t StateHash() const;
+
+private:
+    SimConfig config;
+    double tickInterval;
+    double clockOffset = 0.0;
+    InputRecorder* recorder = nullptr;
+    JobSystem* jobs = nullptr;
+    ShotLog* shotLog = nullptr;
+    std::vector<InputEvent> tickEvents;
+    Camera camera;
+    TargetManager targetManager;
+    CollisionWorld world; // Arena boxes, which stop shots; targets are hit through targetManager
+    bool keys[1024] = {};
+    float cursorX, cursorY;
+    float rawCursorX = 0.0f, rawCursorY = 0.0f; // In window pixels, for mouse deltas
+    bool firstMouse = true;
+    double lastMouseTime = -1.0;
+    int shots = 0, hits = 0, sweptHits = 0;
+    uint64_t tick = 0;
+    CameraHistory history;
+    std::vector<InputEvent> pendingShots;
+    double latencyLast = 0.0, latencySum = 0.0, latencyMax = 0.0;
+    std::vector<double> spawnTimes; // When each target last appeared, for reaction times
+    ShotStats shotStats;
+    ShotStats::Summary shotSummary;
+    std::vector<glm::vec3> previousPositions;
+    // Targets that changed on a tick (respawns), so Publish brings a reused snapshot up to
+    // date without copying every target. A snapshot older than the log, or than a tick
+    // where every target moved, is copied whole.
+    struct TargetChange {
+        uint64_t tick;
+        int id;
+    };
+    static const size_t TARGET_CHANGE_CAPACITY = 1024;
+    TargetChange targetChanges[TARGET_CHANGE_CAPACITY];
+    size_t targetChangeCount = 0;
+    uint64_t forgottenChangeTick = 0; // Newest tick whose changes have left the log
+    uint64_t allTargetsChangedTick = 0;
+    uint64_t allocatingTicks = 0, lastAllocatingTick = 0;
+    glm::vec3 previousCameraPosition;
+    float previousYaw, previousPitch;
+
+    static const size_t INPUT_QUEUE_CAPACITY = 4096;
+    SpscQueue<InputEvent, INPUT_QUEUE_CAPACITY> inputQueue;
+    TripleBuffer<SimSnapshot> snapshots;
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    std::chrono::steady_clock::time_point epoch;
+
+    // Scratch for SweepShot, sized in the constructor to hold every view in the sweep window
+    std::vector<CameraHistory::View> sweepViews;
+    std::vector<glm::vec3> sweepDirections;
+
+    void Run();
+    double TickTime(uint64_t n) const { return static_cast<double>(n) * tickInterval + clockOffset; }
+    void Apply(const InputEvent& event);
+    void ResolveShot(const InputEvent& click);
+    void TargetChanged(int id);
+    int SweepShot(double time, const glm::vec3& origin, const glm::mat4& projection);
+    void Publish();
+};
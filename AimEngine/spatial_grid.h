@@ -0,0 +1,176 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+// Uniform grid over a fixed box. Every entry is stored in each cell its bounding box
+// overlaps, so a ray only looks at the entries in the cells it actually passes through.
+class SpatialGrid {
+public:
+    // cellReserve is the most entries a cell is expected to hold; reserving it up front
+    // keeps Insert and Update from allocating once the grid is built
+    void Build(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float cellSize, int maxId, int cellReserve = 0) {
+        this->boundsMin = boundsMin;
+        this->cellSize = cellSize;
+        invCellSize = 1.0f / cellSize;
+        for (int axis = 0; axis < 3; ++axis) {
+            float extent = boundsMax[axis] - boundsMin[axis];
+            dims[axis] = std::max(1, static_cast<int>(std::ceil(extent * invCellSize)));
+        }
+        // Snap the upper bound to whole cells so the DDA and the cell lookup agree
+        this->boundsMax = boundsMin + glm::vec3(dims[0] * cellSize, dims[1] * cellSize, dims[2] * cellSize);
+
+        cells.assign(static_cast<size_t>(dims[0]) * dims[1] * dims[2], std::vector<int>());
+        if (cellReserve > 0) {
+            for (std::vector<int>& cell : cells) cell.reserve(cellReserve);
+        }
+        entries.assign(maxId, Entry());
+    }
+
+    void Insert(int id, const glm::vec3& center, float radius) {
+        if (id >= static_cast<int>(entries.size())) {
+            entries.resize(id + 1);
+        }
+        Entry& entry = entries[id];
+        ComputeRange(center, radius, entry);
+        entry.active = true;
+        ForEachCell(entry, [&](std::vector<int>& cell) { cell.push_back(id); });
+    }
+
+    void Remove(int id) {
+        Entry& entry = entries[id];
+        if (!entry.active) return;
+        ForEachCell(entry, [&](std::vector<int>& cell) {
+            auto it = std::find(cell.begin(), cell.end(), id);
+            if (it != cell.end()) {
+                *it = cell.back();
+                cell.pop_back();
+            }
+        });
+        entry.active = false;
+    }
+
+    // Moves an entry, only touching the cell lists when its cell range actually changes
+    void Update(int id, const glm::vec3& center, float radius) {
+        Entry moved;
+        ComputeRange(center, radius, moved);
+        const Entry& current = entries[id];
+        if (current.active &&
+            moved.lo[0] == current.lo[0] && moved.lo[1] == current.lo[1] && moved.lo[2] == current.lo[2] &&
+            moved.hi[0] == current.hi[0] && moved.hi[1] == current.hi[1] && moved.hi[2] == current.hi[2]) {
+            return;
+        }
+        Remove(id);
+        Insert(id, center, radius);
+    }
+
+    // Walks the cells pierced by the ray between tMin and tMax in front-to-back order
+    // (Amanatides & Woo). visit(ids, tEnter, tExit) returns false to stop the walk.
+    template <typename Visitor>
+    void TraverseRay(const glm::vec3& origin, const glm::vec3& direction, float tMin, float tMax, Visitor visit) const {
+        if (cells.empty()) return;
+
+        // Clip the ray against the grid bounds
+        float tEnter = tMin;
+        float tExit = tMax;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (direction[axis] == 0.0f) {
+                if (origin[axis] < boundsMin[axis] || origin[axis] > boundsMax[axis]) return;
+                continue;
+            }
+            float invDir = 1.0f / direction[axis];
+            float t0 = (boundsMin[axis] - origin[axis]) * invDir;
+            float t1 = (boundsMax[axis] - origin[axis]) * invDir;
+            if (t0 > t1) std::swap(t0, t1);
+            tEnter = std::max(tEnter, t0);
+            tExit = std::min(tExit, t1);
+        }
+        if (tEnter > tExit) return;
+
+        glm::vec3 entryPoint = origin + direction * tEnter;
+        int cell[3], step[3], limit[3];
+        float tNext[3], tDelta[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            cell[axis] = CellCoord(entryPoint[axis], axis);
+            if (direction[axis] > 0.0f) {
+                step[axis] = 1;
+                limit[axis] = dims[axis];
+                float boundary = boundsMin[axis] + (cell[axis] + 1) * cellSize;
+                tNext[axis] = tEnter + (boundary - entryPoint[axis]) / direction[axis];
+                tDelta[axis] = cellSize / direction[axis];
+            }
+            else if (direction[axis] < 0.0f) {
+                step[axis] = -1;
+                limit[axis] = -1;
+                float boundary = boundsMin[axis] + cell[axis] * cellSize;
+                tNext[axis] = tEnter + (boundary - entryPoint[axis]) / direction[axis];
+                tDelta[axis] = -cellSize / direction[axis];
+            }
+            else {
+                step[axis] = 0;
+                limit[axis] = -1;
+                tNext[axis] = FLT_MAX;
+                tDelta[axis] = FLT_MAX;
+            }
+        }
+
+        float tCell = tEnter;
+        while (true) {
+            int axis = (tNext[0] < tNext[1]) ? (tNext[0] < tNext[2] ? 0 : 2) : (tNext[1] < tNext[2] ? 1 : 2);
+            float tLeave = std::min(tNext[axis], tExit);
+
+            const std::vector<int>& ids = cells[CellIndex(cell[0], cell[1], cell[2])];
+            if (!ids.empty() && !visit(ids, tCell, tLeave)) return;
+
+            if (tNext[axis] > tExit) return;
+            cell[axis] += step[axis];
+            if (cell[axis] == limit[axis]) return;
+            tCell = tNext[axis];
+            tNext[axis] += tDelta[axis];
+        }
+    }
+
+    size_t CellCount() const { return cells.size(); }
+
+private:
+    struct Entry {
+        int lo[3] = { 0, 0, 0 };
+        int hi[3] = { -1, -1, -1 };
+        bool active = false;
+    };
+
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    float cellSize = 1.0f;
+    float invCellSize = 1.0f;
+    int dims[3] = { 0, 0, 0 };
+    std::vector<std::vector<int>> cells;
+    std::vector<Entry> entries;
+
+    int CellCoord(float value, int axis) const {
+        int coord = static_cast<int>(std::floor((value - boundsMin[axis]) * invCellSize));
+        return std::min(std::max(coord, 0), dims[axis] - 1);
+    }
+
+    size_t CellIndex(int x, int y, int z) const {
+        return (static_cast<size_t>(z) * dims[1] + y) * dims[0] + x;
+    }
+
+    // Entries outside the bounds are clamped into the border cells so they are never lost
+    void ComputeRange(const glm::vec3& center, float radius, Entry& entry) const {
+        for (int axis = 0; axis < 3; ++axis) {
+            entry.lo[axis] = CellCoord(center[axis] - radius, axis);
+            entry.hi[axis] = CellCoord(center[axis] + radius, axis);
+        }
+    }
+
+    template <typename Fn>
+    void ForEachCell(const Entry& entry, Fn fn) {
+        for (int z = entry.lo[2]; z <= entry.hi[2]; ++z)
+            for (int y = entry.lo[1]; y <= entry.hi[1]; ++y)
+                for (int x = entry.lo[0]; x <= entry.hi[0]; ++x)
+                    fn(cells[CellIndex(x, y, z)]);
+    }
+};
@@ -0,0 +1,80 @@
+#include "sphere_batcher.h"
+
+void SphereBatcher::SetView(const glm::mat4& view, const glm::mat4& projection, int viewportHeight) {
+    this->view = view;
+    this->projection = projection;
+    this->viewportHeight = viewportHeight;
+    frustum = Frustum::FromViewProjection(projection * view);
+}
+
+int SphereBatcher::SelectLod(const glm::vec3& center, float radius) const {
+    float depth = -(view * glm::vec4(center, 1.0f)).z;
+    if (depth <= radius) return 0;
+    // projection[1][1] is cot(fovy / 2): world units at depth 1 to half the viewport height
+    float pixelRadius = radius / depth * projection[1][1] * 0.5f * viewportHeight;
+    int lod = 0;
+    while (lod < LOD_COUNT - 1 && pixelRadius < LOD_MIN_PIXEL_RADIUS[lod]) lod++;
+    return lod;
+}
+
+SphereBatcher::Batches SphereBatcher::Append(const SphereInstance* instances, int count, std::vector<SphereInstance>& out, FrameArena& arena, JobSystem* jobs) {
+    Batches batches;
+    if (count <= 0) return batches;
+
+    // Ranges are classified on their own, then scattered LOD-major and range-minor, so each
+    // LOD is contiguous and in input order however the work was split
+    int size = jobs ? jobs->RangeSize(count, PARALLEL_GRAIN) : count;
+    int ranges = (count + size - 1) / size;
+    visible = arena.Allocate<int>(count);
+    lods = arena.Allocate<unsigned char>(count);
+    rangeVisible = arena.Allocate<int>(ranges);
+    rangeLods = arena.Allocate<std::array<int, LOD_COUNT>>(ranges);
+
+    auto classify = [&](int begin, int end) { Classify(instances, begin, end, begin / size); };
+    if (jobs) jobs->ParallelFor(count, PARALLEL_GRAIN, classify);
+    else classify(0, count);
+
+    int base = static_cast<int>(out.size());
+    int offset = base;
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        batches.lodFirst[lod] = offset;
+        for (int range = 0; range < ranges; ++range) {
+            int rangeCount = rangeLods[range][lod];
+            rangeLods[range][lod] = offset;
+            offset += rangeCount;
+        }
+        batches.lodCount[lod] = offset - batches.lodFirst[lod];
+    }
+    batches.visible = offset - base;
+    batches.culled = count - batches.visible;
+    out.resize(offset);
+
+    SphereInstance* output = out.data();
+    auto scatter = [&](int begin, int) { Scatter(instances, begin, begin / size, output); };
+    if (jobs) jobs->ParallelFor(count, PARALLEL_GRAIN, scatter);
+    else scatter(0, count);
+    return batches;
+}
+
+void SphereBatcher::Classify(const SphereInstance* instances, int begin, int end, int range) {
+    int* rangeVisibleIndices = visible + begin;
+    int visibleCount = CullSpheres(frustum, instances + begin, sizeof(SphereInstance), end - begin, rangeVisibleIndices);
+
+    std::array<int, LOD_COUNT> counts = {};
+    for (int k = 0; k < visibleCount; ++k) {
+        int i = begin + rangeVisibleIndices[k];
+        rangeVisibleIndices[k] = i;
+        int lod = SelectLod(instances[i].position, instances[i].radius);
+        lods[begin + k] = static_cast<unsigned char>(lod);
+        counts[lod]++;
+    }
+    rangeVisible[range] = visibleCount;
+    rangeLods[range] = counts;
+}
+
+void SphereBatcher::Scatter(const SphereInstance* instances, int begin, int range, SphereInstance* out) {
+    std::array<int, LOD_COUNT>& cursor = rangeLods[range];
+    for (int k = 0; k < rangeVisible[range]; ++k) {
+        out[cursor[lods[begin + k]]++] = instances[visible[begin + k]];
+    }
+}
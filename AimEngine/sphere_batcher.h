@@ -0,0 +1,61 @@
+#pragma once
+#include "frustum.h"
+#include "frame_arena.h"
+#include "job_system.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+// Per-instance data for DrawSpheresInstanced, laid out exactly as uploaded to the GPU
+struct SphereInstance {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+};
+
+// CPU side of instanced sphere drawing, kept free of GL: culls instances against the view
+// frustum, picks each one's LOD from its size on screen and groups them by LOD. Within a
+// LOD instances keep the order they were given in, with or without a job system.
+class SphereBatcher {
+public:
+    // LODs finest first, and the smallest on-screen radius in pixels each one is used for
+    static const int LOD_COUNT = 4;
+    static constexpr float LOD_MIN_PIXEL_RADIUS[LOD_COUNT] = { 48.0f, 16.0f, 6.0f, 0.0f };
+
+    struct Batches {
+        int visible = 0;
+        int culled = 0;
+        int lodFirst[LOD_COUNT] = {}; // Index of the LOD's first instance in the output
+        int lodCount[LOD_COUNT] = {};
+    };
+
+    void SetView(const glm::mat4& view, const glm::mat4& projection, int viewportHeight);
+    const Frustum& GetFrustum() const { return frustum; }
+
+    // Picks the coarsest sphere whose facets stay under a few pixels at this size on screen
+    int SelectLod(const glm::vec3& center, float radius) const;
+
+    // Appends the visible instances to out, grouped by LOD. Splits the work across jobs
+    // when given a job system and enough instances. Scratch space comes from arena and is
+    // done with when Append returns.
+    Batches Append(const SphereInstance* instances, int count, std::vector<SphereInstance>& out, FrameArena& arena, JobSystem* jobs = nullptr);
+
+private:
+    // Instances per job; culling and LOD selection cost a few nanoseconds each
+    static const int PARALLEL_GRAIN = 4096;
+
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    Frustum frustum = Frustum::FromViewProjection(glm::mat4(1.0f));
+    int viewportHeight = 1;
+
+    // Scratch for the current Append, indexed like the input: each range keeps its visible
+    // instances at its start
+    int* visible = nullptr;
+    unsigned char* lods = nullptr;
+    int* rangeVisible = nullptr;
+    std::array<int, LOD_COUNT>* rangeLods = nullptr; // Counts, then output cursors
+
+    void Classify(const SphereInstance* instances, int begin, int end, int range);
+    void Scatter(const SphereInstance* instances, int begin, int range, SphereInstance* out);
+};
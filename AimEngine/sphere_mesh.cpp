@@ -0,0 +1,76 @@
+#include "sphere_mesh.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+void GenerateIcosphere(int subdivisions, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> points = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 },
+    };
+    for (glm::vec3& p : points) p = glm::normalize(p);
+
+    std::vector<unsigned int> faces = {
+        0, 11, 5,  0, 5, 1,   0, 1, 7,   0, 7, 10,  0, 10, 11,
+        1, 5, 9,   5, 11, 4,  11, 10, 2, 10, 7, 6,  7, 1, 8,
+        3, 9, 4,   3, 4, 2,   3, 2, 6,   3, 6, 8,   3, 8, 9,
+        4, 9, 5,   2, 4, 11,  6, 2, 10,  8, 6, 7,   9, 8, 1,
+    };
+
+    // Every subdivision quadruples the faces, and V - E + F = 2 with E = 3F / 2
+    subdivisions = std::max(subdivisions, 0);
+    size_t finalFaces = static_cast<size_t>(20) << (2 * subdivisions);
+    points.reserve(finalFaces / 2 + 2);
+    faces.reserve(finalFaces * 3);
+    std::vector<unsigned int> next;
+    next.reserve(finalFaces * 3);
+
+    // Edge midpoints by (lower, higher) vertex index, in an open-addressed table sized for
+    // the edges of the last level to split at under half load
+    size_t tableSize = 64;
+    while (tableSize < finalFaces) tableSize *= 2;
+    std::vector<uint64_t> edgeKeys(tableSize);
+    std::vector<unsigned int> edgeMidpoints(tableSize);
+    const uint64_t EMPTY = ~0ull;
+
+    for (int level = 0; level < subdivisions; ++level) {
+        std::fill(edgeKeys.begin(), edgeKeys.end(), EMPTY);
+        auto midpoint = [&](unsigned int a, unsigned int b) {
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (tableSize - 1);
+            while (edgeKeys[slot] != EMPTY) {
+                if (edgeKeys[slot] == key) return edgeMidpoints[slot];
+                slot = (slot + 1) & (tableSize - 1);
+            }
+            unsigned int index = static_cast<unsigned int>(points.size());
+            points.push_back(glm::normalize(points[a] + points[b]));
+            edgeKeys[slot] = key;
+            edgeMidpoints[slot] = index;
+            return index;
+        };
+
+        next.clear();
+        for (size_t i = 0; i < faces.size(); i += 3) {
+            unsigned int a = faces[i], b = faces[i + 1], c = faces[i + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            unsigned int split[] = { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca };
+            next.insert(next.end(), split, split + 12);
+        }
+        faces.swap(next);
+    }
+
+    unsigned int baseVertex = static_cast<unsigned int>(vertices.size() / 3);
+    vertices.reserve(vertices.size() + points.size() * 3);
+    indices.reserve(indices.size() + faces.size());
+    for (const glm::vec3& p : points) {
+        vertices.push_back(p.x);
+        vertices.push_back(p.y);
+        vertices.push_back(p.z);
+    }
+    for (unsigned int index : faces) {
+        indices.push_back(baseVertex + index);
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <vector>
+
+// Unit icosphere: an icosahedron whose triangles are split in four per subdivision, with
+// the new vertices pushed out onto the sphere. Shared edge midpoints are looked up so
+// every vertex is stored once. Appends xyz positions to vertices and triangles to indices,
+// offset past the vertices already there so several spheres can share the same buffers.
+void GenerateIcosphere(int subdivisions, std::vector<float>& vertices, std::vector<unsigned int>& indices);
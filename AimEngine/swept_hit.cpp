@@ -0,0 +1,86 @@
+#include "swept_hit.h"
+#include "ray_kernel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Widens the bounding cone so float rounding in the SIMD and scalar culls can never drop a
+// sphere the exact test would hit; the slack is far wider than the rounding error
+const float CONE_SLACK_RADIANS = 1e-3f;
+
+// Directions closer than this are treated as one ray
+const float MIN_ARC_SINE = 1e-6f;
+
+// How far along the arc from a to b (0 to 1) the aim last passed through the sphere at v
+// relative to the origin, or a negative value if it never did
+float LastCrossing(const glm::vec3& v, float radius, const glm::vec3& a, const glm::vec3& b) {
+    float radiusSq = radius * radius;
+    if (glm::dot(v, v) <= radiusSq) return 1.0f;
+
+    glm::vec3 normal = glm::cross(a, b);
+    float sine = glm::length(normal);
+    if (sine < MIN_ARC_SINE) {
+        // No turn: the ray along b
+        float along = glm::dot(v, b);
+        return along > 0.0f && glm::dot(v, v) - along * along <= radiusSq ? 1.0f : -1.0f;
+    }
+    normal /= sine;
+
+    // The sphere cuts the plane of the arc in a disc; the rays in the plane that hit it
+    // are the angles within halfWidth of the disc's direction
+    float height = glm::dot(v, normal);
+    float discRadiusSq = radiusSq - height * height;
+    if (discRadiusSq < 0.0f) return -1.0f;
+    glm::vec3 side = glm::cross(normal, a);
+    float px = glm::dot(v, a), py = glm::dot(v, side);
+    float distance = std::sqrt(px * px + py * py);
+    if (distance * distance <= discRadiusSq) return 1.0f;
+
+    float arc = std::atan2(sine, glm::dot(a, b));
+    float center = std::atan2(py, px);
+    float halfWidth = std::asin(std::sqrt(discRadiusSq) / distance);
+    if (center - halfWidth > arc || center + halfWidth < 0.0f) return -1.0f;
+    return std::min(center + halfWidth, arc) / arc;
+}
+
+}
+
+int SweptRaySphere(const TargetSoA& soa, const glm::vec3& origin, const glm::vec3* directions, int count, int* candidates, float& sweep) {
+    if (count <= 0) return -1;
+
+    // Every ray on an arc is at most as far from the axis as the arc's ends, so a cone
+    // around the directions' mean that holds every direction holds the whole path
+    glm::vec3 sum(0.0f);
+    for (int k = 0; k < count; ++k) sum += directions[k];
+    float sumLength = glm::length(sum);
+    glm::vec3 axis = sumLength > MIN_ARC_SINE ? sum / sumLength : directions[count - 1];
+    float cosAngle = 1.0f;
+    for (int k = 0; k < count; ++k) cosAngle = std::min(cosAngle, glm::dot(axis, directions[k]));
+    float angle = std::min(std::acos(std::max(-1.0f, std::min(1.0f, cosAngle))) + CONE_SLACK_RADIANS, 3.14159265f);
+    int candidateCount = SphereConeCandidates(soa, origin, axis, std::cos(angle), std::sin(angle), candidates);
+
+    int best = -1;
+    float bestSweep = -1.0f;
+    for (int c = 0; c < candidateCount; ++c) {
+        int i = candidates[c];
+        glm::vec3 v = glm::vec3(soa.x[i], soa.y[i], soa.z[i]) - origin;
+        // Newest arc first, from directions[k - 1] to directions[k]; the first one crossed
+        // holds the sphere's latest crossing. A single direction is an arc of length 0.
+        for (int k = std::max(count - 1, 1); k >= 1; --k) {
+            // Nothing on this arc or an older one can beat the best so far
+            if (k <= bestSweep) break;
+            float crossing = LastCrossing(v, soa.radius[i], directions[count > 1 ? k - 1 : 0], directions[count > 1 ? k : 0]);
+            if (crossing < 0.0f) continue;
+            float at = count > 1 ? k - 1 + crossing : 0.0f;
+            // Candidates come in index order, so ties keep the lowest index
+            if (at > bestSweep) {
+                bestSweep = at;
+                best = i;
+            }
+            break;
+        }
+    }
+    if (best >= 0) sweep = bestSweep;
+    return best;
+}
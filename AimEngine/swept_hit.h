@@ -0,0 +1,18 @@
+#pragma once
+#include "target_soa.h"
+#include <glm/glm.hpp>
+
+// Continuous hit detection for a view that turns while the player shoots. A fast flick can
+// move the aim further between two mouse samples than a small target is wide, so the ray at
+// the click alone can step straight over the target the player swept across. Here the aim
+// turns along great-circle arcs between consecutive ray directions, and a target is hit
+// when any ray on that path passes through it.
+//
+// Spheres are first culled against one cone bounding the whole path with the SIMD kernel,
+// then each candidate is tested exactly against the arcs, newest first.
+//
+// directions are normalized, oldest first, and end with the ray at the click. Returns the
+// live target the aim crossed most recently, or -1; sweep is set to where on the path that
+// was, from 0 at the first direction to count - 1 at the last. candidates is scratch with
+// room for soa.count indices.
+int SweptRaySphere(const TargetSoA& soa, const glm::vec3& origin, const glm::vec3* directions, int count, int* candidates, float& sweep);
@@ -1,48 +1,257 @@
 #pragma once
 #include "target.h"
+#include "spatial_grid.h"
+#include "target_soa.h"
+#include "ray_kernel.h"
+#include "swept_hit.h"
+#include "target_placement.h"
+#include "target_motion.h"
+#include "job_system.h"
 #include <vector>
+#include <iostream>
+#include <cfloat>
 
 class TargetManager {
 public:
     std::vector<Target> targets;
 
-    TargetManager(int count, float minX, float maxX, float minY, float maxY, float z, float radius) {
-        // First create all targets with empty existing list
-        for (int i = 0; i < count; ++i) {
-            targets.emplace_back(minX, maxX, minY, maxY, z, radius, std::vector<Target*>());
+    // Placement draws from its own PRNG, so the same seed always gives the same layout and
+    // respawn sequence
+    TargetManager(int count, float minX, float maxX, float minY, float maxY, float z, float radius, uint64_t seed = Rng::ClockSeed())
+        : minX(minX), maxX(maxX), minY(minY), maxY(maxY), z(z), radius(radius) {
+        placer.Seed(seed);
+        motion.Seed(~seed);
+        placer.Init(minX, maxX, minY, maxY, 2.0f * radius * TARGET_SPACING);
+        std::vector<glm::vec2> positions;
+        int spaced = placer.Layout(count, positions);
+        if (spaced < count) {
+            std::cout << "WARNING::TARGETS::SPAWN_AREA_TOO_SMALL\n" << (count - spaced) << " of " << count << " targets overlap" << std::endl;
         }
 
-        // Then reset them with proper collision checking
-        std::vector<Target*> targetPtrs;
-        for (auto& target : targets) {
-            targetPtrs.push_back(&target);
+        targets.reserve(count);
+        for (const auto& p : positions) {
+            targets.emplace_back(glm::vec3(p.x, p.y, z), radius);
         }
-        for (auto& target : targets) {
-            target.Reset(minX, maxX, minY, maxY, z, targetPtrs);
+
+        RebuildSpatialIndex();
+    }
+
+    // Sets every target moving around its current position. Call again after changing the
+    // number of targets.
+    void SetMotion(MotionPattern pattern, float speed, float size) {
+        motion.Init(pattern, speed, size, static_cast<int>(targets.size()), static_cast<int>(soa.x.size()));
+        if (motion.Moving()) {
+            for (size_t i = 0; i < targets.size(); ++i) {
+                targets[i].position = motion.Reset(static_cast<int>(i), targets[i].position);
+            }
         }
+        RebuildSpatialIndex();
     }
 
-    bool CheckHits(const glm::vec3& rayOrigin, const glm::vec3& rayDirection) {
-        bool hitAny = false;
-        for (auto& target : targets) {
-            if (!target.hit && target.CheckRayIntersection(rayOrigin, rayDirection)) {
-                target.hit = true;
-                hitAny = true;
+    // Moves the targets dt seconds along their paths, across jobs when given a job system
+    void Advance(float dt, JobSystem* jobs = nullptr) {
+        if (!motion.Moving()) return;
+        motion.Advance(dt, soa, jobs);
+        auto sync = [this](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                targets[i].position = glm::vec3(soa.x[i], soa.y[i], soa.z[i]);
             }
+        };
+        if (jobs) jobs->ParallelFor(static_cast<int>(targets.size()), PARALLEL_GRAIN, sync);
+        else sync(0, static_cast<int>(targets.size()));
+    }
+
+    // Marks the nearest live target in front of the ray origin as hit
+    bool CheckHits(const glm::vec3& rayOrigin, const glm::vec3& rayDirection) {
+        int id = Raycast(rayOrigin, rayDirection);
+        if (id < 0) return false;
+        MarkHit(id);
+        return true;
+    }
+
+    // Flags a target as hit and queues it for the next ResetHitTargets
+    void MarkHit(int id) {
+        if (targets[id].hit) return;
+        targets[id].hit = true;
+        soa.SetHit(id, true);
+        pendingRespawns.push_back(id);
+    }
+
+    // Index of the nearest live target in front of the ray origin, or -1 on a miss
+    int Raycast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection) const {
+        float t;
+        return Raycast(rayOrigin, rayDirection, t);
+    }
+
+    // Same, also giving how far along the (normalized) ray the target was hit
+    int Raycast(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float& nearestT) const {
+        glm::vec3 direction = rayDirection;
+        float lengthSq = glm::dot(direction, direction);
+        if (std::fabs(lengthSq - 1.0f) > 1e-5f) {
+            direction /= std::sqrt(lengthSq);
+        }
+        nearestT = FLT_MAX;
+
+        // Small fields are cheaper to brute force with the SIMD kernel than to walk the grid.
+        // So are moving ones: keeping the grid current would cost more every tick than a
+        // scan costs per shot, so it is left stale while targets move.
+        if (soa.count <= LINEAR_SCAN_LIMIT || motion.Moving()) {
+            return RaySphereNearest(soa, rayOrigin, direction, nearestT);
+        }
+
+        int nearest = -1;
+        grid.TraverseRay(rayOrigin, direction, 0.0f, FLT_MAX, [&](const std::vector<int>& ids, float, float tExit) {
+            int id = RaySphereNearestIndexed(soa, ids.data(), static_cast<int>(ids.size()), rayOrigin, direction, nearestT);
+            if (id >= 0) nearest = id;
+            // Cells are visited front to back, so a hit inside this cell cannot be beaten
+            return nearestT > tExit;
+        });
+        return nearest;
+    }
+
+    // The live target whose surface the ray passes closest to, and that gap in world units;
+    // -1 when every target is hit. A scan of the SoA store with the SIMD kernel, which only
+    // runs on a miss.
+    int NearestMiss(const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float& distance) const {
+        glm::vec3 direction = rayDirection;
+        float lengthSq = glm::dot(direction, direction);
+        if (std::fabs(lengthSq - 1.0f) > 1e-5f) {
+            direction /= std::sqrt(lengthSq);
         }
-        return hitAny;
+        int nearest = RaySphereNearestGap(soa, rayOrigin, direction, distance);
+        distance = nearest >= 0 ? std::max(0.0f, distance) : 0.0f;
+        return nearest;
+    }
+
+    // The live target the aim passed through most recently while turning through the given
+    // ray directions (oldest first, normalized), or -1; see SweptRaySphere
+    int SweepCast(const glm::vec3& rayOrigin, const glm::vec3* rayDirections, int count, float& sweep) {
+        return SweptRaySphere(soa, rayOrigin, rayDirections, count, sweepCandidates.data(), sweep);
+    }
+
+    // Raycast for many rays, across jobs when given a job system
+    void RaycastBatch(const glm::vec3* rayOrigins, const glm::vec3* rayDirections, int count, int* results, JobSystem* jobs = nullptr) const {
+        auto cast = [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                results[i] = Raycast(rayOrigins[i], rayDirections[i]);
+            }
+        };
+        if (jobs) jobs->ParallelFor(count, RAYS_PER_JOB, cast);
+        else cast(0, count);
     }
 
+    // Respawns every target marked since the last call; O(1) expected per target
     void ResetHitTargets(float minX, float maxX, float minY, float maxY, float z) {
-        std::vector<Target*> targetPtrs;
-        for (auto& target : targets) {
-            targetPtrs.push_back(&target);
+        bool boundsChanged = minX != this->minX || maxX != this->maxX || minY != this->minY || maxY != this->maxY || z != this->z;
+        if (boundsChanged) {
+            this->minX = minX; this->maxX = maxX;
+            this->minY = minY; this->maxY = maxY;
+            this->z = z;
+            placer.Init(minX, maxX, minY, maxY, 2.0f * radius * TARGET_SPACING);
+            for (size_t i = 0; i < targets.size(); ++i) {
+                if (!targets[i].hit) {
+                    glm::vec3 spot = Spot(static_cast<int>(i));
+                    placer.Claim(static_cast<int>(i), glm::vec2(spot.x, spot.y));
+                }
+            }
+        }
+
+        // Free every hit spot first so respawns can use any of them
+        for (int id : pendingRespawns) {
+            placer.Release(id);
         }
 
-        for (auto& target : targets) {
-            if (target.hit) {
-                target.Reset(minX, maxX, minY, maxY, z, targetPtrs);
+        for (int id : pendingRespawns) {
+            Target& target = targets[id];
+            glm::vec3 spot = Spot(id);
+            glm::vec2 p;
+            if (placer.Respawn(id, p)) {
+                spot = glm::vec3(p.x, p.y, z);
+            }
+            target.position = motion.Moving() ? motion.Reset(id, spot) : spot;
+            target.hit = false;
+            soa.Set(id, target.position, target.radius);
+            soa.SetHit(id, false);
+            if (!boundsChanged) {
+                grid.Update(id, target.position, target.radius);
             }
         }
+        pendingRespawns.clear();
+
+        if (boundsChanged) {
+            RebuildSpatialIndex();
+        }
+    }
+
+    // Rebuilds the SoA store and the grid from scratch; needed after editing targets directly
+    void RebuildSpatialIndex() {
+        soa.Resize(static_cast<int>(targets.size()));
+        if (motion.Moving() && motion.Count() != soa.count) {
+            std::cout << "ERROR::TARGETS::MOTION_COUNT_MISMATCH\nCall SetMotion after changing the number of targets" << std::endl;
+            motion.Init(MotionPattern::STATIC, 0.0f, 0.0f, 0, 0);
+        }
+        pendingRespawns.clear();
+        pendingRespawns.reserve(targets.size());
+        sweepCandidates.resize(soa.x.size());
+        for (size_t i = 0; i < targets.size(); ++i) {
+            soa.Set(static_cast<int>(i), targets[i].position, targets[i].radius);
+            soa.SetHit(static_cast<int>(i), targets[i].hit);
+            if (targets[i].hit) pendingRespawns.push_back(static_cast<int>(i));
+        }
+
+        float maxRadius = radius;
+        glm::vec3 boundsMin(minX, minY, z);
+        glm::vec3 boundsMax(maxX, maxY, z);
+        for (size_t i = 0; i < targets.size(); ++i) {
+            maxRadius = std::max(maxRadius, targets[i].radius);
+            boundsMin = glm::min(boundsMin, Spot(static_cast<int>(i)));
+            boundsMax = glm::max(boundsMax, Spot(static_cast<int>(i)));
+        }
+        boundsMin -= glm::vec3(maxRadius);
+        boundsMax += glm::vec3(maxRadius);
+
+        // Aim for roughly one target per cell, but never cells smaller than a target
+        float area = (boundsMax.x - boundsMin.x) * (boundsMax.y - boundsMin.y);
+        float cellSize = 2.0f * maxRadius;
+        if (!targets.empty()) {
+            cellSize = std::max(cellSize, std::sqrt(area / static_cast<float>(targets.size())));
+        }
+
+        // Spaced targets can only crowd so many into (or over the edge of) one cell; room for
+        // that many means respawns never grow a cell
+        float spacing = 2.0f * radius * TARGET_SPACING;
+        float perAxis = spacing > 0.0f ? std::floor((cellSize + 2.0f * maxRadius) / spacing) + 1.0f : 1.0f;
+        int cellReserve = static_cast<int>(std::min(perAxis * perAxis, static_cast<float>(targets.size())));
+        grid.Build(boundsMin, boundsMax, cellSize, static_cast<int>(targets.size()), cellReserve);
+        for (size_t i = 0; i < targets.size(); ++i) {
+            grid.Insert(static_cast<int>(i), targets[i].position, targets[i].radius);
+        }
+    }
+
+    const TargetSoA& GetSoA() const { return soa; }
+    const TargetMotion& GetMotion() const { return motion; }
+
+    // Minimum gap between targets as a multiple of the touching distance
+    static constexpr float TARGET_SPACING = 1.2f;
+
+    // Above this many static targets CheckHits walks the grid instead of scanning the SoA store
+    static const int LINEAR_SCAN_LIMIT = 512;
+
+    // Work per job when splitting a pass across a job system
+    static const int PARALLEL_GRAIN = 8192;
+    static const int RAYS_PER_JOB = 64;
+
+private:
+    float minX, maxX, minY, maxY, z, radius;
+    SpatialGrid grid;
+    TargetSoA soa;
+    TargetPlacer placer;
+    TargetMotion motion;
+    std::vector<int> pendingRespawns;
+    std::vector<int> sweepCandidates; // Scratch for SweepCast
+
+    // Where the placer put a target: its position, or the anchor of its path when moving
+    glm::vec3 Spot(int id) const {
+        return motion.Moving() ? motion.Anchor(id) : targets[id].position;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,314 @@
+#include "target_motion.h"
+#include "cpu_features.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Control point offset for a quarter circle drawn as a cubic Bezier (radial error 0.03%)
+const float ARC_HANDLE = 0.5522847f;
+const float HALF_PI = 1.5707963f;
+
+// Segments are never shorter than this in world units, so a target cannot end hundreds of
+// them in one step
+const float MIN_SEGMENT_LENGTH = 0.05f;
+
+namespace {
+
+bool scalarOnly = false;
+
+const char* const PATTERN_NAMES[] = { "static", "strafe", "circle", "spline" };
+
+// The hot arrays seen by the kernels
+struct SegmentLanes {
+    const float *ax, *ay, *az, *bx, *by, *bz, *cx, *cy, *cz, *dx, *dy, *dz;
+    const float* rate;
+    float* u;
+    float *x, *y, *z;
+};
+
+// Same operation order as the SIMD paths and TargetMotion::Position, so every path moves
+// targets bit for bit the same and replays do not depend on the CPU
+inline void EvaluateLane(const SegmentLanes& lanes, int i) {
+    float t = lanes.u[i];
+    lanes.x[i] = ((lanes.ax[i] * t + lanes.bx[i]) * t + lanes.cx[i]) * t + lanes.dx[i];
+    lanes.y[i] = ((lanes.ay[i] * t + lanes.by[i]) * t + lanes.cy[i]) * t + lanes.dy[i];
+    lanes.z[i] = ((lanes.az[i] * t + lanes.bz[i]) * t + lanes.cz[i]) * t + lanes.dz[i];
+}
+
+int AdvanceScalar(const SegmentLanes& lanes, int begin, int end, float dt, int* ended, int written) {
+    for (int i = begin; i < end; ++i) {
+        lanes.u[i] = lanes.u[i] + lanes.rate[i] * dt;
+        EvaluateLane(lanes, i);
+        ended[written] = i;
+        written += lanes.u[i] >= 1.0f;
+    }
+    return written;
+}
+
+#ifdef AIM_SIMD_X86
+
+const bool hasAvx2 = CpuHasAvx2();
+
+AIM_TARGET_AVX2 inline __m256 CubicAvx2(const float* a, const float* b, const float* c, const float* d, int i, __m256 t) {
+    __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(a + i), t), _mm256_loadu_ps(b + i));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_loadu_ps(c + i));
+    return _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_loadu_ps(d + i));
+}
+
+AIM_TARGET_AVX2 int AdvanceAvx2(const SegmentLanes& lanes, int begin, int end, float dt, int* ended) {
+    const __m256 step = _mm256_set1_ps(dt);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    int written = 0;
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 t = _mm256_add_ps(_mm256_loadu_ps(lanes.u + i), _mm256_mul_ps(_mm256_loadu_ps(lanes.rate + i), step));
+        _mm256_storeu_ps(lanes.u + i, t);
+        _mm256_storeu_ps(lanes.x + i, CubicAvx2(lanes.ax, lanes.bx, lanes.cx, lanes.dx, i, t));
+        _mm256_storeu_ps(lanes.y + i, CubicAvx2(lanes.ay, lanes.by, lanes.cy, lanes.dy, i, t));
+        _mm256_storeu_ps(lanes.z + i, CubicAvx2(lanes.az, lanes.bz, lanes.cz, lanes.dz, i, t));
+
+        // Almost always zero; the compaction only runs when a segment ended
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(t, one, _CMP_GE_OQ));
+        if (mask) {
+            for (int lane = 0; lane < 8; ++lane) {
+                ended[written] = i + lane;
+                written += (mask >> lane) & 1;
+            }
+        }
+    }
+    return AdvanceScalar(lanes, i, end, dt, ended, written);
+}
+
+inline __m128 CubicSse2(const float* a, const float* b, const float* c, const float* d, int i, __m128 t) {
+    __m128 p = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), t), _mm_loadu_ps(b + i));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_loadu_ps(c + i));
+    return _mm_add_ps(_mm_mul_ps(p, t), _mm_loadu_ps(d + i));
+}
+
+int AdvanceSse2(const SegmentLanes& lanes, int begin, int end, float dt, int* ended) {
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 one = _mm_set1_ps(1.0f);
+    int written = 0;
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 t = _mm_add_ps(_mm_loadu_ps(lanes.u + i), _mm_mul_ps(_mm_loadu_ps(lanes.rate + i), step));
+        _mm_storeu_ps(lanes.u + i, t);
+        _mm_storeu_ps(lanes.x + i, CubicSse2(lanes.ax, lanes.bx, lanes.cx, lanes.dx, i, t));
+        _mm_storeu_ps(lanes.y + i, CubicSse2(lanes.ay, lanes.by, lanes.cy, lanes.dy, i, t));
+        _mm_storeu_ps(lanes.z + i, CubicSse2(lanes.az, lanes.bz, lanes.cz, lanes.dz, i, t));
+
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(t, one));
+        if (mask) {
+            for (int lane = 0; lane < 4; ++lane) {
+                ended[written] = i + lane;
+                written += (mask >> lane) & 1;
+            }
+        }
+    }
+    return AdvanceScalar(lanes, i, end, dt, ended, written);
+}
+
+#endif
+
+// Advances u and writes the positions of lanes begin..end-1; the lanes whose segment ended
+// go to ended, and their number is returned
+int AdvanceLanes(const SegmentLanes& lanes, int begin, int end, float dt, int* ended) {
+#ifdef AIM_SIMD_X86
+    if (!scalarOnly) {
+        if (hasAvx2) return AdvanceAvx2(lanes, begin, end, dt, ended);
+        return AdvanceSse2(lanes, begin, end, dt, ended);
+    }
+#endif
+    return AdvanceScalar(lanes, begin, end, dt, ended, 0);
+}
+
+}
+
+bool ParseMotionPattern(const char* name, MotionPattern& pattern) {
+    for (int i = 0; i < 4; ++i) {
+        if (std::strcmp(name, PATTERN_NAMES[i]) == 0) {
+            pattern = static_cast<MotionPattern>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* MotionPatternName(MotionPattern pattern) {
+    return PATTERN_NAMES[static_cast<int>(pattern)];
+}
+
+const char* MotionKernelName() {
+#ifdef AIM_SIMD_X86
+    if (!scalarOnly) return hasAvx2 ? "avx2" : "sse2";
+#endif
+    return "scalar";
+}
+
+void SetMotionKernelScalarOnly(bool enabled) {
+    scalarOnly = enabled;
+}
+
+void TargetMotion::Init(MotionPattern pattern, float speed, float size, int count, int paddedCount) {
+    this->pattern = pattern;
+    this->speed = speed;
+    this->size = size;
+    paths.assign(count, Path());
+    for (std::vector<float>* lane : { &ax, &ay, &az, &bx, &by, &bz, &cx, &cy, &cz, &dx, &dy, &dz, &u, &rate }) {
+        lane->assign(paddedCount, 0.0f);
+    }
+    ended.assign(paddedCount, 0);
+}
+
+glm::vec3 TargetMotion::Reset(int i, const glm::vec3& anchor) {
+    Path& path = paths[i];
+    path.anchor = anchor;
+    path.end = anchor;
+    path.angle = 0.0f;
+    path.direction = rng.Next01() < 0.5f ? -1.0f : 1.0f;
+    u[i] = 0.0f;
+
+    switch (pattern) {
+    case MotionPattern::STATIC:
+        SetSegment(i, anchor, anchor, anchor, anchor, 0.0f);
+        rate[i] = 0.0f;
+        return anchor;
+
+    case MotionPattern::CIRCLE:
+        path.angle = rng.Next01() * 4.0f * HALF_PI;
+        path.end = anchor + size * glm::vec3(std::cos(path.angle), std::sin(path.angle), 0.0f);
+        break;
+
+    case MotionPattern::SPLINE:
+        path.points[1] = anchor;
+        path.points[2] = RandomPoint(anchor);
+        path.points[3] = RandomPoint(anchor);
+        break;
+
+    default:
+        break;
+    }
+    NextSegment(i);
+    return glm::vec3(dx[i], dy[i], dz[i]);
+}
+
+void TargetMotion::Advance(float dt, TargetSoA& soa, JobSystem* jobs) {
+    if (!Moving()) return;
+
+    SegmentLanes lanes = { ax.data(), ay.data(), az.data(), bx.data(), by.data(), bz.data(),
+                           cx.data(), cy.data(), cz.data(), dx.data(), dy.data(), dz.data(),
+                           rate.data(), u.data(), soa.x.data(), soa.y.data(), soa.z.data() };
+    // Padding lanes have a zero rate, so whole blocks can be processed without a tail
+    int count = static_cast<int>(u.size());
+    if (!jobs || count < PARALLEL_GRAIN * 2) {
+        int endedCount = AdvanceLanes(lanes, 0, count, dt, ended.data());
+        FinishSegments(ended.data(), endedCount, soa);
+        return;
+    }
+
+    // Ranges of whole SIMD blocks, each listing its ended targets at its own offset in ended
+    const int block = TargetSoA::SIMD_WIDTH;
+    int blocks = count / block;
+    int size = jobs->RangeSize(blocks, PARALLEL_GRAIN / block);
+    rangeEnded.resize((blocks + size - 1) / size);
+    jobs->ParallelFor(blocks, PARALLEL_GRAIN / block, [&](int first, int last) {
+        rangeEnded[first / size] = AdvanceLanes(lanes, first * block, last * block, dt, ended.data() + first * block);
+    });
+
+    // New segments draw from the shared generator, so they are built in target order to
+    // keep the simulation independent of the thread count
+    for (size_t range = 0; range < rangeEnded.size(); ++range) {
+        FinishSegments(ended.data() + range * size * block, rangeEnded[range], soa);
+    }
+}
+
+// Carries the time left over past the end of a segment into the next one
+void TargetMotion::FinishSegments(const int* targets, int count, TargetSoA& soa) {
+    for (int k = 0; k < count; ++k) {
+        int i = targets[k];
+        while (u[i] >= 1.0f) {
+            float leftover = (u[i] - 1.0f) / rate[i];
+            NextSegment(i);
+            u[i] = leftover * rate[i];
+        }
+        soa.Set(i, Position(i), soa.radius[i]);
+    }
+}
+
+glm::vec3 TargetMotion::Position(int i) const {
+    float t = u[i];
+    return glm::vec3(((ax[i] * t + bx[i]) * t + cx[i]) * t + dx[i],
+                     ((ay[i] * t + by[i]) * t + cy[i]) * t + dy[i],
+                     ((az[i] * t + bz[i]) * t + cz[i]) * t + dz[i]);
+}
+
+glm::vec3 TargetMotion::Velocity(int i) const {
+    float t = u[i];
+    return rate[i] * glm::vec3((3.0f * ax[i] * t + 2.0f * bx[i]) * t + cx[i],
+                               (3.0f * ay[i] * t + 2.0f * by[i]) * t + cy[i],
+                               (3.0f * az[i] * t + 2.0f * bz[i]) * t + cz[i]);
+}
+
+// Builds the segment that starts where the current one ends
+void TargetMotion::NextSegment(int i) {
+    Path& path = paths[i];
+    glm::vec3 from = path.end;
+
+    switch (pattern) {
+    case MotionPattern::STRAFE: {
+        // Turn at a random point on the far side so the rhythm cannot be learned
+        path.direction = -path.direction;
+        path.end = path.anchor + glm::vec3(path.direction * size * (0.3f + 0.7f * rng.Next01()), 0.0f, 0.0f);
+        glm::vec3 step = (path.end - from) * (1.0f / 3.0f);
+        SetSegment(i, from, from + step, path.end - step, path.end, glm::length(path.end - from));
+        break;
+    }
+
+    case MotionPattern::CIRCLE: {
+        float start = path.angle;
+        path.angle += path.direction * HALF_PI;
+        if (std::fabs(path.angle) > 4.0f * HALF_PI) path.angle -= path.direction * 4.0f * HALF_PI;
+        glm::vec3 startRadial(std::cos(start), std::sin(start), 0.0f);
+        glm::vec3 endRadial(std::cos(path.angle), std::sin(path.angle), 0.0f);
+        path.end = path.anchor + size * endRadial;
+        // Tangents along the direction of travel
+        glm::vec3 startTangent = path.direction * glm::vec3(-startRadial.y, startRadial.x, 0.0f);
+        glm::vec3 endTangent = path.direction * glm::vec3(-endRadial.y, endRadial.x, 0.0f);
+        SetSegment(i, from, from + ARC_HANDLE * size * startTangent, path.end - ARC_HANDLE * size * endTangent, path.end, HALF_PI * size);
+        break;
+    }
+
+    case MotionPattern::SPLINE: {
+        glm::vec3* p = path.points;
+        p[0] = p[1];
+        p[1] = p[2];
+        p[2] = p[3];
+        p[3] = RandomPoint(path.anchor);
+        path.end = p[2];
+        SetSegment(i, p[1], p[1] + (p[2] - p[0]) * (1.0f / 6.0f), p[2] - (p[3] - p[1]) * (1.0f / 6.0f), p[2], glm::length(p[2] - p[1]));
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void TargetMotion::SetSegment(int i, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float length) {
+    // Bezier to power basis
+    glm::vec3 a = p3 - p0 + 3.0f * (p1 - p2);
+    glm::vec3 b = 3.0f * (p0 - 2.0f * p1 + p2);
+    glm::vec3 c = 3.0f * (p1 - p0);
+    ax[i] = a.x; ay[i] = a.y; az[i] = a.z;
+    bx[i] = b.x; by[i] = b.y; bz[i] = b.z;
+    cx[i] = c.x; cy[i] = c.y; cz[i] = c.z;
+    dx[i] = p0.x; dy[i] = p0.y; dz[i] = p0.z;
+    rate[i] = speed / std::max(length, MIN_SEGMENT_LENGTH);
+}
+
+glm::vec3 TargetMotion::RandomPoint(const glm::vec3& anchor) {
+    float offsetX = (2.0f * rng.Next01() - 1.0f) * size;
+    float offsetY = (2.0f * rng.Next01() - 1.0f) * size;
+    return anchor + glm::vec3(offsetX, offsetY, 0.0f);
+}
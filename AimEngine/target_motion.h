@@ -0,0 +1,86 @@
+#pragma once
+#include "target_soa.h"
+#include "random.h"
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+class JobSystem;
+
+enum class MotionPattern : uint8_t {
+    STATIC,
+    STRAFE, // Side to side at constant speed, turning at a random distance from the anchor
+    CIRCLE, // Around the anchor in the plane facing the camera
+    SPLINE  // Catmull-Rom curve through random points near the anchor
+};
+
+// "static", "strafe", "circle" or "spline", for command lines
+bool ParseMotionPattern(const char* name, MotionPattern& pattern);
+const char* MotionPatternName(MotionPattern pattern);
+
+// Name of the kernel TargetMotion::Advance dispatches to ("avx2", "sse2" or "scalar")
+const char* MotionKernelName();
+
+// Forces the scalar fallback, for benchmarking and for checking the SIMD paths
+void SetMotionKernelScalarOnly(bool enabled);
+
+// Kinematics for moving targets. Every target follows a chain of cubic segments
+// p(u) = ((a u + b) u + c) u + d for u in [0, 1), so one vectorized loop moves all of them
+// whatever their pattern: u advances by rate * dt and the polynomial is evaluated straight
+// into the TargetSoA positions. The pattern only matters when a segment ends, which is
+// rare enough to be handled per target in scalar code.
+class TargetMotion {
+public:
+    void Seed(uint64_t seed) { rng.Seed(seed); }
+
+    // Starts a path of the given pattern for targets 0..count-1. speed is in world units
+    // per second; size is how far a target strays from its anchor.
+    void Init(MotionPattern pattern, float speed, float size, int count, int paddedCount);
+
+    // Restarts a target's path at a new anchor and returns its position
+    glm::vec3 Reset(int i, const glm::vec3& anchor);
+
+    // Advances every target by dt seconds and writes the positions to soa.x/y/z. Large
+    // fields are split across jobs; the result is the same with or without them.
+    void Advance(float dt, TargetSoA& soa, JobSystem* jobs = nullptr);
+
+    bool Moving() const { return pattern != MotionPattern::STATIC; }
+    int Count() const { return static_cast<int>(paths.size()); }
+    MotionPattern Pattern() const { return pattern; }
+    const glm::vec3& Anchor(int i) const { return paths[i].anchor; }
+
+    // Current position and velocity (world units per second) of one target
+    glm::vec3 Position(int i) const;
+    glm::vec3 Velocity(int i) const;
+
+private:
+    // Per-target pattern state; only touched when a segment ends
+    struct Path {
+        glm::vec3 anchor;
+        glm::vec3 end;       // Where the current segment ends
+        glm::vec3 points[4]; // SPLINE: Catmull-Rom points; the segment runs from 1 to 2
+        float angle;         // CIRCLE: angle of end around the anchor, radians
+        float direction;     // CIRCLE: turning direction; STRAFE: side being headed to (+1 or -1)
+    };
+
+    MotionPattern pattern = MotionPattern::STATIC;
+    float speed = 0.0f;
+    float size = 0.0f;
+    Rng rng;
+    std::vector<Path> paths;
+
+    // Hot state, padded like TargetSoA; padding lanes never move
+    std::vector<float> ax, ay, az, bx, by, bz, cx, cy, cz, dx, dy, dz;
+    std::vector<float> u, rate;
+    // Targets per job when advancing in parallel
+    static const int PARALLEL_GRAIN = 8192;
+
+    std::vector<int> ended;      // Scratch: targets whose segment ended this step
+    std::vector<int> rangeEnded; // How many of them each job found
+
+    void FinishSegments(const int* targets, int count, TargetSoA& soa);
+    void NextSegment(int i);
+    // Makes the cubic Bezier p0..p3 the target's current segment, traversed in length / speed
+    void SetSegment(int i, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float length);
+    glm::vec3 RandomPoint(const glm::vec3& anchor);
+};
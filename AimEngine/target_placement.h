@@ -0,0 +1,192 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "random.h"
+
+// Places targets on the spawn rectangle with a guaranteed minimum spacing.
+// A background grid with cells of minDistance / sqrt(2) holds at most one target per
+// cell, so a spacing check only looks at the 5x5 cells around a candidate point.
+class TargetPlacer {
+public:
+    // Restarts the random stream; layouts and respawns are a pure function of the seed
+    void Seed(uint64_t seed) {
+        rng.Seed(seed);
+    }
+
+    void Init(float minX, float maxX, float minY, float maxY, float minDistance) {
+        this->minX = minX;
+        this->minY = minY;
+        width = std::max(maxX - minX, 0.0f);
+        height = std::max(maxY - minY, 0.0f);
+        this->minDistance = minDistance;
+        cellSize = minDistance / std::sqrt(2.0f);
+        gridW = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+        gridH = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+        cells.assign(static_cast<size_t>(gridW) * gridH, -1);
+        positions.clear();
+        cellOf.clear();
+    }
+
+    // Bridson's algorithm: grows a maximal Poisson-disk set over the whole rectangle in
+    // O(area), then hands out a random subset so small counts are not clustered around
+    // the seed point. Returns how many of the count positions respect the spacing; the
+    // rest (only when the rectangle is too small) are placed without the guarantee.
+    int Layout(int count, std::vector<glm::vec2>& out) {
+        out.clear();
+        std::vector<glm::vec2> samples;
+        std::vector<int> active;
+        std::vector<int> sampleGrid(cells.size(), -1);
+
+        auto accept = [&](const glm::vec2& p) {
+            sampleGrid[CellIndex(p)] = static_cast<int>(samples.size());
+            active.push_back(static_cast<int>(samples.size()));
+            samples.push_back(p);
+        };
+        accept(glm::vec2(minX + Random01() * width, minY + Random01() * height));
+
+        const int CANDIDATES_PER_POINT = 30;
+        while (!active.empty()) {
+            int slot = RandomInt(static_cast<int>(active.size()));
+            glm::vec2 center = samples[active[slot]];
+            bool found = false;
+            for (int k = 0; k < CANDIDATES_PER_POINT; ++k) {
+                // Uniform over the annulus [r, 2r]
+                float angle = Random01() * 6.2831853f;
+                float distance = minDistance * std::sqrt(1.0f + 3.0f * Random01());
+                glm::vec2 candidate = center + glm::vec2(std::cos(angle), std::sin(angle)) * distance;
+                if (InBounds(candidate) && IsFree(sampleGrid, samples, candidate)) {
+                    accept(candidate);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                active[slot] = active.back();
+                active.pop_back();
+            }
+        }
+
+        // Partial Fisher-Yates: only the first count entries need shuffling
+        int spaced = std::min(count, static_cast<int>(samples.size()));
+        for (int i = 0; i < spaced; ++i) {
+            std::swap(samples[i], samples[i + RandomInt(static_cast<int>(samples.size()) - i)]);
+        }
+
+        std::fill(cells.begin(), cells.end(), -1);
+        positions.assign(count, glm::vec2(0.0f));
+        cellOf.assign(count, -1);
+        for (int id = 0; id < count; ++id) {
+            glm::vec2 p = id < spaced ? samples[id] : glm::vec2(minX + Random01() * width, minY + Random01() * height);
+            if (id < spaced) Occupy(id, p);
+            else positions[id] = p;
+            out.push_back(p);
+        }
+        return spaced;
+    }
+
+    // Takes id out of the grid so its spot can be reused
+    void Release(int id) {
+        if (cellOf[id] >= 0) {
+            cells[cellOf[id]] = -1;
+            cellOf[id] = -1;
+        }
+    }
+
+    // Adds an already placed target back to the grid if its position keeps the spacing
+    bool Claim(int id, const glm::vec2& p) {
+        if (id >= static_cast<int>(positions.size())) {
+            positions.resize(id + 1, glm::vec2(0.0f));
+            cellOf.resize(id + 1, -1);
+        }
+        Release(id);
+        if (!InBounds(p) || !IsFree(cells, positions, p)) return false;
+        Occupy(id, p);
+        return true;
+    }
+
+    // Finds a new spaced position for a released target. Random darts cost O(1) expected
+    // while the field is not saturated; a sweep over the free cells is the fallback.
+    bool Respawn(int id, glm::vec2& out) {
+        Release(id);
+        const int DART_ATTEMPTS = 30;
+        for (int attempt = 0; attempt < DART_ATTEMPTS; ++attempt) {
+            glm::vec2 candidate(minX + Random01() * width, minY + Random01() * height);
+            if (IsFree(cells, positions, candidate)) {
+                Occupy(id, candidate);
+                out = candidate;
+                return true;
+            }
+        }
+
+        int cellCount = static_cast<int>(cells.size());
+        int start = RandomInt(cellCount);
+        for (int offset = 0; offset < cellCount; ++offset) {
+            int cell = (start + offset) % cellCount;
+            if (cells[cell] >= 0) continue;
+            float cellX = minX + (cell % gridW) * cellSize;
+            float cellY = minY + (cell / gridW) * cellSize;
+            for (int attempt = 0; attempt < 4; ++attempt) {
+                glm::vec2 candidate(cellX + Random01() * cellSize, cellY + Random01() * cellSize);
+                if (InBounds(candidate) && IsFree(cells, positions, candidate)) {
+                    Occupy(id, candidate);
+                    out = candidate;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    float minX = 0.0f, minY = 0.0f, width = 0.0f, height = 0.0f;
+    float minDistance = 1.0f, cellSize = 1.0f;
+    int gridW = 1, gridH = 1;
+    std::vector<int> cells;           // id occupying each cell, or -1
+    std::vector<glm::vec2> positions; // by id
+    std::vector<int> cellOf;          // cell index by id, or -1 when not in the grid
+    Rng rng;
+
+    float Random01() {
+        return rng.Next01();
+    }
+
+    int RandomInt(int n) {
+        return rng.NextInt(n);
+    }
+
+    bool InBounds(const glm::vec2& p) const {
+        return p.x >= minX && p.x <= minX + width && p.y >= minY && p.y <= minY + height;
+    }
+
+    int CellIndex(const glm::vec2& p) const {
+        int cx = std::min(std::max(static_cast<int>((p.x - minX) / cellSize), 0), gridW - 1);
+        int cy = std::min(std::max(static_cast<int>((p.y - minY) / cellSize), 0), gridH - 1);
+        return cy * gridW + cx;
+    }
+
+    void Occupy(int id, const glm::vec2& p) {
+        int cell = CellIndex(p);
+        cells[cell] = id;
+        cellOf[id] = cell;
+        positions[id] = p;
+    }
+
+    // Anything within minDistance lives at most two cells away
+    bool IsFree(const std::vector<int>& grid, const std::vector<glm::vec2>& points, const glm::vec2& p) const {
+        int cell = CellIndex(p);
+        int cx = cell % gridW;
+        int cy = cell / gridW;
+        float minDistanceSq = minDistance * minDistance;
+        for (int y = std::max(cy - 2, 0); y <= std::min(cy + 2, gridH - 1); ++y) {
+            for (int x = std::max(cx - 2, 0); x <= std::min(cx + 2, gridW - 1); ++x) {
+                int other = grid[y * gridW + x];
+                if (other < 0) continue;
+                glm::vec2 delta = points[other] - p;
+                if (glm::dot(delta, delta) < minDistanceSq) return false;
+            }
+        }
+        return true;
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+// Structure-of-arrays copy of the target spheres for the SIMD hit kernels.
+// Arrays are padded to a multiple of SIMD_WIDTH; padding lanes are flagged as hit
+// so the kernels can always process whole blocks.
+struct TargetSoA {
+    static const int SIMD_WIDTH = 16;
+
+    std::vector<float> x, y, z, radius;
+    std::vector<uint32_t> hitMask; // bit (i % 32) of word (i / 32)
+    int count = 0;
+
+    void Resize(int newCount) {
+        count = newCount;
+        size_t padded = static_cast<size_t>((newCount + SIMD_WIDTH - 1) / SIMD_WIDTH) * SIMD_WIDTH;
+        x.assign(padded, 0.0f);
+        y.assign(padded, 0.0f);
+        z.assign(padded, 0.0f);
+        radius.assign(padded, 0.0f);
+        hitMask.assign(padded / 32 + 1, 0u);
+        for (size_t i = newCount; i < padded; ++i) {
+            SetHit(static_cast<int>(i), true);
+        }
+    }
+
+    void Set(int i, const glm::vec3& position, float sphereRadius) {
+        x[i] = position.x;
+        y[i] = position.y;
+        z[i] = position.z;
+        radius[i] = sphereRadius;
+    }
+
+    bool IsHit(int i) const {
+        return (hitMask[i >> 5] >> (i & 31)) & 1u;
+    }
+
+    void SetHit(int i, bool hit) {
+        if (hit) hitMask[i >> 5] |= 1u << (i & 31);
+        else hitMask[i >> 5] &= ~(1u << (i & 31));
+    }
+
+    // Hit bits for the 8 lanes starting at a multiple of 8
+    uint32_t HitBits8(int base) const {
+        return (hitMask[base >> 5] >> (base & 31)) & 0xFFu;
+    }
+
+    // Hit bits for the 4 lanes starting at a multiple of 4
+    uint32_t HitBits4(int base) const {
+        return (hitMask[base >> 5] >> (base & 31)) & 0xFu;
+    }
+};
@@ -0,0 +1,156 @@
+// Plays many bot sessions of one scenario across all cores and prints throughput and hit
+// statistics, for calibrating how hard a scenario is. Session i seeds its targets and its
+// bot from --seed + i and touches nothing shared, so the results, and the batch hash over
+// every session's final state, do not depend on --threads.
+//
+//   aim_batch [--sessions N] [--seconds S] [--threads N] [--seed N] [--expect HASH]
+//             [--motion PATTERN] [--targets N] [--radius R] [--speed V] [--sweep MS]
+//             [--reaction MS] [--fitts A B] [--error F] [--tremor PX]
+#include "../aim_bot.h"
+#include "../job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BatchArgs {
+    int sessions = 1000;
+    double seconds = 60.0;
+    int threads = 0; // 0 for every hardware thread
+    uint64_t seed = 1;
+    MotionPattern motion = MotionPattern::STATIC;
+    int targets = 10;
+    float radius = 0.25f;
+    float speed = 3.0f;
+    float sweepMs = 0.0f;
+    AimModel model;
+    bool hasExpected = false;
+    uint64_t expected = 0;
+};
+
+bool ParseArgs(int argc, char** argv, BatchArgs& args) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--sessions") == 0 && hasValue) args.sessions = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--seconds") == 0 && hasValue) args.seconds = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) args.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue) args.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--motion") == 0 && hasValue && ParseMotionPattern(argv[i + 1], args.motion)) ++i;
+        else if (std::strcmp(arg, "--targets") == 0 && hasValue) args.targets = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--radius") == 0 && hasValue) args.radius = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--speed") == 0 && hasValue) args.speed = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--sweep") == 0 && hasValue) args.sweepMs = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--reaction") == 0 && hasValue) args.model.reactionMs = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--fitts") == 0 && i + 2 < argc) {
+            args.model.fittsAMs = static_cast<float>(std::atof(argv[++i]));
+            args.model.fittsBMs = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(arg, "--error") == 0 && hasValue) args.model.endpointError = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--tremor") == 0 && hasValue) args.model.tremorPixels = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--expect") == 0 && hasValue) {
+            args.hasExpected = true;
+            args.expected = std::strtoull(argv[++i], nullptr, 16);
+        }
+        else {
+            std::fprintf(stderr, "unknown argument: %s\n", arg);
+            return false;
+        }
+    }
+    return args.sessions > 0 && args.seconds > 0.0 && args.threads >= 0 && args.targets > 0 && args.radius > 0.0f &&
+           args.sweepMs >= 0.0f && args.model.fittsAMs > 0.0f && args.model.endpointError >= 0.0f && args.model.tremorPixels >= 0.0f;
+}
+
+double Percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[std::max<size_t>(rank, 1) - 1];
+}
+
+}
+
+int main(int argc, char** argv) {
+    BatchArgs args;
+    if (!ParseArgs(argc, argv, args)) {
+        std::fprintf(stderr, "usage: aim_batch [--sessions N] [--seconds S] [--threads N] [--seed N] [--expect HASH]\n"
+                             "                 [--motion PATTERN] [--targets N] [--radius R] [--speed V] [--sweep MS]\n"
+                             "                 [--reaction MS] [--fitts A B] [--error F] [--tremor PX]\n");
+        return 1;
+    }
+
+    SimConfig config;
+    config.targetMotion = args.motion;
+    config.targetCount = args.targets;
+    config.targetRadius = args.radius;
+    config.targetSpeed = args.speed;
+    config.sweepSeconds = args.sweepMs / 1000.0f;
+    // Widen the wall for large counts so targets keep their spacing, as aim_replay --generate does
+    float halfWidth = std::max(5.0f, 0.6f * std::sqrt((float)args.targets));
+    config.targetMinX = -halfWidth;
+    config.targetMaxX = halfWidth;
+    config.targetMaxY = std::max(config.targetMaxY, config.targetMinY + halfWidth);
+
+    // One session per job: sessions are long and independent, so the only thing to share
+    // out is whole sessions
+    int threads = args.threads > 0 ? args.threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    JobSystem jobs(threads - 1);
+    std::vector<BotSessionResult> results(args.sessions);
+    auto start = std::chrono::steady_clock::now();
+    jobs.ParallelFor(args.sessions, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            SimConfig session = config;
+            session.seed = args.seed + i;
+            results[i] = RunBotSession(session, args.model, (args.seed + i) ^ 0xB07, args.seconds);
+        }
+    });
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Merged in session order, so the totals come out the same on any thread count
+    int64_t shots = 0, hits = 0, sweptHits = 0;
+    double timeToKillSum = 0.0, missDistanceSum = 0.0;
+    int64_t misses = 0;
+    std::vector<double> accuracy, timeToKill;
+    uint64_t hash = 14695981039346656037ull;
+    for (const BotSessionResult& result : results) {
+        shots += result.shots;
+        hits += result.hits;
+        sweptHits += result.sweptHits;
+        timeToKillSum += result.shotStats.timeToKillMean * result.hits;
+        missDistanceSum += result.shotStats.missDistanceMean * (result.shots - result.hits);
+        misses += result.shots - result.hits;
+        accuracy.push_back(result.shotStats.accuracy);
+        timeToKill.push_back(result.shotStats.timeToKillP50);
+        for (int byte = 0; byte < 8; ++byte) {
+            hash = (hash ^ ((result.stateHash >> (8 * byte)) & 0xFF)) * 1099511628211ull;
+        }
+    }
+
+    double simSeconds = args.sessions * args.seconds;
+    std::printf("sessions:     %d x %.0f s, %d %s targets of radius %.2f\n", args.sessions, args.seconds, args.targets,
+                MotionPatternName(args.motion), args.radius);
+    std::printf("throughput:   %.1f sessions/s on %d threads (%.2f s, %.0fx real time)\n", args.sessions / wallSeconds, threads,
+                wallSeconds, simSeconds / wallSeconds);
+    std::printf("hits:         %" PRId64 "/%" PRId64 " (%.1f%%), %.1f per minute", hits, shots, shots > 0 ? 100.0 * hits / shots : 0.0,
+                60.0 * hits / simSeconds);
+    if (args.sweepMs > 0.0f) std::printf(", %" PRId64 " swept", sweptHits);
+    std::printf("\n");
+    std::printf("accuracy:     %.1f/%.1f/%.1f%% p10/p50/p90 over sessions\n", 100.0 * Percentile(accuracy, 0.10),
+                100.0 * Percentile(accuracy, 0.50), 100.0 * Percentile(accuracy, 0.90));
+    std::printf("time to kill: %.0f ms mean, session medians %.0f/%.0f/%.0f ms p10/p50/p90\n", hits > 0 ? 1000.0 * timeToKillSum / hits : 0.0,
+                1000.0 * Percentile(timeToKill, 0.10), 1000.0 * Percentile(timeToKill, 0.50), 1000.0 * Percentile(timeToKill, 0.90));
+    std::printf("misses:       %.3f from target on average\n", misses > 0 ? missDistanceSum / misses : 0.0);
+    std::printf("batch hash:   %016" PRIx64 "\n", hash);
+
+    if (args.hasExpected && hash != args.expected) {
+        std::printf("MISMATCH: expected batch %016" PRIx64 "\n", args.expected);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Re-simulates a recorded session with no window and prints the score and a state hash.
+// Two replays of the same file must print the same hash; --expect turns that into an
+// exit code for scripts. --generate writes a synthetic session (random flicks, clicks and
+// strafing) for testing the replay itself.
+//
+//   aim_replay <recording> [--repeat N] [--expect HASH] [--threads N] [--shots out.shots]
+//   aim_replay --generate <recording> [--seconds S] [--seed N] [--motion PATTERN] [--targets N] [--sweep MS]
+#include "../recording.h"
+#include "../job_system.h"
+#include "../shot_log.h"
+#include "../random.h"
+#include "../allocation_counter.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct ReplayArgs {
+    const char* path = nullptr;
+    bool generate = false;
+    int repeat = 1;
+    int threads = 1;
+    const char* shotLogPath = nullptr;
+    double seconds = 60.0;
+    uint64_t seed = 1;
+    MotionPattern motion = MotionPattern::STATIC;
+    int targets = 10;
+    float sweepMs = 0.0f;
+    bool hasExpected = false;
+    uint64_t expected = 0;
+};
+
+bool ParseArgs(int argc, char** argv, ReplayArgs& args) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--generate") == 0 && hasValue) {
+            args.generate = true;
+            args.path = argv[++i];
+        }
+        else if (std::strcmp(arg, "--repeat") == 0 && hasValue) args.repeat = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) args.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--shots") == 0 && hasValue) args.shotLogPath = argv[++i];
+        else if (std::strcmp(arg, "--seconds") == 0 && hasValue) args.seconds = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue) args.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--motion") == 0 && hasValue && ParseMotionPattern(argv[i + 1], args.motion)) ++i;
+        else if (std::strcmp(arg, "--targets") == 0 && hasValue) args.targets = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--sweep") == 0 && hasValue) args.sweepMs = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(arg, "--expect") == 0 && hasValue) {
+            args.hasExpected = true;
+            args.expected = std::strtoull(argv[++i], nullptr, 16);
+        }
+        else if (arg[0] != '-' && !args.path) args.path = arg;
+        else {
+            std::fprintf(stderr, "unknown argument: %s\n", arg);
+            return false;
+        }
+    }
+    return args.path && args.repeat > 0 && args.threads > 0 && args.seconds > 0.0 && args.targets > 0 && args.sweepMs >= 0.0f;
+}
+
+// A bot that picks a new target every quarter second, steers the cursor onto it, clicks
+// shortly after and strafes now and then. Mouse samples arrive at 1 kHz like a gaming mouse.
+int Generate(const ReplayArgs& args) {
+    SimConfig config;
+    config.seed = args.seed;
+    config.targetMotion = args.motion;
+    config.targetCount = args.targets;
+    config.sweepSeconds = args.sweepMs / 1000.0f;
+    // Widen the wall for large counts so targets keep their spacing, as aim_frame_bench does
+    float halfWidth = std::max(5.0f, 0.6f * std::sqrt((float)args.targets));
+    config.targetMinX = -halfWidth;
+    config.targetMaxX = halfWidth;
+    config.targetMaxY = std::max(config.targetMaxY, config.targetMinY + halfWidth);
+    Simulation simulation(config);
+    InputRecorder recorder;
+    if (!recorder.Open(args.path, config)) return 1;
+    simulation.SetRecorder(&recorder);
+
+    Rng rng(args.seed ^ 0x5EED);
+    uint64_t ticks = static_cast<uint64_t>(args.seconds * config.tickRate);
+    double interval = 1.0 / config.tickRate;
+    glm::mat4 projection = glm::perspective(glm::radians(config.fovDegrees), config.screenWidth / config.screenHeight, config.nearPlane, config.farPlane);
+    float x = config.screenWidth / 2.0f, y = config.screenHeight / 2.0f;
+    int aimAt = 0;
+    std::vector<InputEvent> events;
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        events.clear();
+        double time = (tick + rng.Next01()) * interval;
+
+        const SimSnapshot& snapshot = simulation.LatestSnapshot();
+        if (tick % 250 == 0) aimAt = rng.NextInt(static_cast<int>(snapshot.targets.size()));
+
+        // Turning the camera also moves the target on screen, so close a fraction of the gap
+        Camera view(snapshot.cameraPosition);
+        view.Yaw = snapshot.yaw;
+        view.Pitch = snapshot.pitch;
+        glm::vec4 clip = projection * view.GetViewMatrix() * glm::vec4(snapshot.targets[aimAt].position, 1.0f);
+        float targetX = (clip.x / clip.w * 0.5f + 0.5f) * config.screenWidth;
+        float targetY = (0.5f - clip.y / clip.w * 0.5f) * config.screenHeight;
+
+        InputEvent move = {};
+        move.type = InputEvent::MOUSE_MOVE;
+        move.time = time;
+        x += (targetX - x) * 0.2f;
+        y += (targetY - y) * 0.2f;
+        move.x = x;
+        move.y = y;
+        move.rawX = x;
+        move.rawY = y;
+        events.push_back(move);
+
+        if (tick % 250 == 40) {
+            InputEvent click = {};
+            click.type = InputEvent::CLICK;
+            click.time = time;
+            events.push_back(click);
+        }
+        if (tick % 1000 == 0 || tick % 1000 == 300) {
+            InputEvent key = {};
+            key.type = InputEvent::KEY;
+            key.time = time;
+            key.key = (tick / 1000) % 2 ? 'A' : 'D';
+            key.pressed = tick % 1000 == 0;
+            events.push_back(key);
+        }
+        simulation.Step(events);
+    }
+    recorder.Close(simulation.CurrentTick());
+
+    const SimSnapshot& snapshot = simulation.LatestSnapshot();
+    std::printf("wrote %s: %" PRIu64 " ticks, %d/%d hits, state %016" PRIx64 "\n",
+        args.path, simulation.CurrentTick(), snapshot.hits, snapshot.shots, simulation.StateHash());
+    return 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    ReplayArgs args;
+    if (!ParseArgs(argc, argv, args)) {
+        std::fprintf(stderr, "usage: aim_replay <recording> [--repeat N] [--expect HASH] [--threads N] [--shots out.shots]\n"
+                             "       aim_replay --generate <recording> [--seconds S] [--seed N] [--motion PATTERN] [--targets N] [--sweep MS]\n");
+        return 1;
+    }
+    if (args.generate) return Generate(args);
+
+    InputRecording recording;
+    if (!recording.Open(args.path)) return 1;
+
+    // Only the first run is logged; the others must match it anyway
+    ShotLog shotLog;
+    if (args.shotLogPath && !shotLog.Open(args.shotLogPath, recording.Config().seed)) return 1;
+
+    JobSystem jobs(args.threads - 1);
+    ReplayResult result;
+    bool consistent = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < args.repeat; ++i) {
+        ReplayResult run = Replay(recording, &jobs, i == 0 && shotLog.IsOpen() ? &shotLog : nullptr);
+        if (i > 0 && run.stateHash != result.stateHash) consistent = false;
+        result = run;
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / args.repeat;
+    double simSeconds = static_cast<double>(result.ticks) / recording.Config().tickRate;
+
+    std::printf("%" PRIu64 " ticks (%.1f s), %d/%d hits, state %016" PRIx64 "\n", result.ticks, simSeconds, result.hits, result.shots, result.stateHash);
+    if (recording.Config().sweepSeconds > 0.0f) {
+        std::printf("swept hits %d (%.0f ms sweep)\n", result.sweptHits, 1000.0 * recording.Config().sweepSeconds);
+    }
+    std::printf("accuracy %.1f%%, time to kill %.0f/%.0f ms p50/p90 (%.0f ms mean), misses %.3f from target\n", 100.0 * result.shotStats.accuracy,
+                1000.0 * result.shotStats.timeToKillP50, 1000.0 * result.shotStats.timeToKillP90, 1000.0 * result.shotStats.timeToKillMean,
+                result.shotStats.missDistanceMean);
+    std::printf("replay %.2f ms, %.0fx real time\n", wallSeconds * 1000.0, simSeconds / wallSeconds);
+    if (AllocationCounter::Enabled()) {
+        std::printf("heap: %" PRIu64 " ticks allocated, the last at tick %" PRIu64 "\n", result.allocatingTicks, result.lastAllocatingTick);
+    }
+
+    if (!consistent) {
+        std::printf("MISMATCH: repeated replays diverged\n");
+        return 1;
+    }
+    if (args.hasExpected && result.stateHash != args.expected) {
+        std::printf("MISMATCH: expected state %016" PRIx64 "\n", args.expected);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Summarizes a shot log written by AimEngine --shots or aim_replay --shots. Scans only the
+// columns it needs, and prints exact time-to-kill percentiles next to the histogram
+// estimates the game keeps while playing.
+//
+//   aim_shot_report <log.shots> [--rows N]   (also print the first N shots)
+#include "../shot_log.h"
+#include "../shot_stats.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+double Percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0.0;
+    size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(p * values.size())));
+    std::nth_element(values.begin(), values.begin() + (rank - 1), values.end());
+    return values[rank - 1];
+}
+
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    int printRows = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--rows") == 0 && i + 1 < argc) printRows = std::atoi(argv[++i]);
+        else if (!path) path = argv[i];
+        else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "usage: aim_shot_report <log.shots> [--rows N]\n");
+        return 1;
+    }
+
+    ShotLogReader log;
+    if (!log.Open(path)) return 1;
+
+    int hits = 0, misses = 0;
+    double missDistanceSum = 0.0, first = 0.0, last = 0.0;
+    std::vector<double> timesToKill;
+    for (uint64_t block = 0; block < log.Blocks(); ++block) {
+        int rows = log.BlockRows(block);
+        const double* time = log.Column<double>(ShotColumn::TIME, block);
+        const uint8_t* hit = log.Column<uint8_t>(ShotColumn::HIT, block);
+        const int32_t* target = log.Column<int32_t>(ShotColumn::TARGET, block);
+        const float* missDistance = log.Column<float>(ShotColumn::MISS_DISTANCE, block);
+        const float* reactionTime = log.Column<float>(ShotColumn::REACTION_TIME, block);
+        if (block == 0 && rows > 0) first = time[0];
+        if (rows > 0) last = time[rows - 1];
+        for (int i = 0; i < rows; ++i) {
+            if (hit[i]) {
+                hits++;
+                timesToKill.push_back(reactionTime[i]);
+            }
+            else if (target[i] >= 0) {
+                misses++;
+                missDistanceSum += missDistance[i];
+            }
+        }
+    }
+
+    // The same shots through the running aggregates, to show how close the estimates are
+    ShotStats stats;
+    for (uint64_t row = 0; row < log.Rows(); ++row) {
+        stats.Add(log.Row(row));
+    }
+    ShotStats::Summary summary = stats.Compute();
+
+    uint64_t shots = log.Rows();
+    std::printf("%s: seed %" PRIu64 ", %" PRIu64 " shots over %.1f s\n", path, log.Seed(), shots, last - first);
+    std::printf("accuracy:      %d/%" PRIu64 " hits, %.1f%%\n", hits, shots, shots > 0 ? 100.0 * hits / shots : 0.0);
+    double p50 = Percentile(timesToKill, 0.50), p90 = Percentile(timesToKill, 0.90);
+    std::printf("time to kill:  %.1f / %.1f ms p50/p90 (running estimate %.1f / %.1f ms)\n", 1000.0 * p50, 1000.0 * p90,
+                1000.0 * summary.timeToKillP50, 1000.0 * summary.timeToKillP90);
+    std::printf("miss distance: %.3f mean over %d misses\n", misses > 0 ? missDistanceSum / misses : 0.0, misses);
+
+    for (uint64_t row = 0; row < std::min<uint64_t>(printRows, shots); ++row) {
+        ShotRecord shot = log.Row(row);
+        std::printf("%10.6f yaw %8.3f pitch %7.3f dir (%6.3f %6.3f %6.3f) target %5d %s %.3f after %.3f s\n", shot.time, shot.yaw,
+                    shot.pitch, shot.direction.x, shot.direction.y, shot.direction.z, shot.target, shot.hit ? "hit " : "miss",
+                    shot.missDistance, shot.reactionTime);
+    }
+    return 0;
+}
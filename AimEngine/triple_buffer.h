@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer handoff of the latest value. The writer
+// fills its private slot and swaps it with the shared middle slot; the reader swaps
+// its slot with the middle one only when something new was published. Neither side
+// ever waits, and slots are reused so their allocations are kept.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side: the slot being filled for the next Publish
+    T& WriteBuffer() { return buffers[writeIndex]; }
+
+    void Publish() {
+        uint32_t previous = middle.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side: returns true when a newer value was published since the last call
+    bool Acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT)) return false;
+        uint32_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& ReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static const uint32_t INDEX_MASK = 0x3;
+    static const uint32_t FRESH_BIT = 0x4;
+
+    T buffers[3];
+    alignas(64) std::atomic<uint32_t> middle{ 1 };
+    alignas(64) uint32_t writeIndex = 0; // Only touched by the writer
+    alignas(64) uint32_t readIndex = 2;  // Only touched by the reader
+};